@@ -0,0 +1,319 @@
+// File in HMMDecompositionDecision, created by Thien Le in July 2018
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "batch.h"
+#include "options.h"
+#include "utilities.h"
+
+// Number of families allocated at first, doubled when full
+#define BATCH_INITIAL_CAPACITY      64
+
+// Family and its estimated cost, sorted to find the order of the families
+typedef struct batch_entry {
+    long    cost;
+    int     index;
+} batch_entry_t;
+
+// Private function templates
+int     add_family              (batch_t * batch, char * input_name);
+int     read_manifest           (batch_t * batch, char * name);
+int     read_directory          (batch_t * batch, char * name);
+int     compare_input_name      (const void * a, const void * b);
+int     compare_cost            (const void * a, const void * b);
+void*   batch_worker            (void * arg);
+
+/* Constructor for the batch, it holds no family until read_batch is called
+ * Input:   pointer to the batch
+ * Output:  0 on success, ERROR otherwise
+ * Effect:  set fields in the batch, initialize its lock
+ */
+int init_batch(batch_t * batch){
+    if(!batch)          PRINT_AND_RETURN("batch is NULL in init_batch",         GENERAL_ERROR);
+
+    batch->num_families = batch->capacity = 0;
+    batch->families = NULL;
+    batch->cost = NULL;
+    batch->order = NULL;
+    batch->status = NULL;
+    batch->next = batch->done = 0;
+    if(pthread_mutex_init(&batch->lock, NULL) != 0)
+                        PRINT_AND_RETURN("cannot create lock in init_batch",    GENERAL_ERROR);
+    return 0;
+}
+
+/* Destructor for the batch that frees all mallocated fields. The batch must not be running
+ * Input:   pointer to the batch
+ * Output:  nothing
+ * Effect:  freeing mallocated blocks, destroy the lock of the batch
+ */
+void destroy_batch(batch_t * batch){
+    int i; //loop variable
+
+    if(!batch) return;
+    for(i = 0; i < batch->num_families; i++){
+        free(batch->families[i].input_name);
+        free(batch->families[i].prefix);
+    }
+    free(batch->families);
+    free(batch->cost);
+    free(batch->order);
+    free(batch->status);
+    pthread_mutex_destroy(&batch->lock);
+    batch->num_families = batch->capacity = 0;
+    batch->families = NULL;
+    batch->cost = NULL;
+    batch->order = batch->status = NULL;
+}
+
+/* Read the alignments of the batch: the lines of a manifest (empty lines and lines starting with # are skipped)
+ * or the regular files of a directory sorted by name
+ * Input:   an initialized batch and the name of the manifest or directory
+ * Output:  0 on success, ERROR otherwise
+ * Effect:  calls malloc, add families to the batch
+ */
+int read_batch(batch_t * batch, char * name){
+    struct stat info;
+    int status;
+
+    if(!batch)                  PRINT_AND_RETURN("batch is NULL in read_batch",             GENERAL_ERROR);
+    if(!name)                   PRINT_AND_RETURN("name is NULL in read_batch",              GENERAL_ERROR);
+    if(stat(name, &info) != 0)  PRINT_AND_RETURN("cannot open batch in read_batch",         OPEN_ERROR);
+
+    status = S_ISDIR(info.st_mode) ? read_directory(batch, name) : read_manifest(batch, name);
+    if(status != SUCCESS)       return status;
+    if(batch->num_families == 0)
+                                PRINT_AND_RETURN("no alignment in batch in read_batch",     GENERAL_ERROR);
+    return 0;
+}
+
+/* Run every family of the batch on a pool of threads. Each family is a single unit of work run by one thread with one
+ * thread for its own jobs, and the threads take the next family from one queue sorted by decreasing cost, so the
+ * largest alignments start first and the smallest ones fill the cores at the end instead of leaving a long tail
+ * A family that fails is recorded in its status and does not stop the others
+ * Input:   a read batch, the settings shared by the families, the prefix of their files or NULL, the number of threads
+ * Output:  0 on success, ERROR otherwise (failed families are not errors)
+ * Effect:  calls malloc, run the pipeline on every family, starts up to num_workers - 1 threads
+ */
+int run_batch(batch_t * batch, family_t * settings, char * prefix, int num_workers){
+    batch_entry_t * entries;
+    struct stat info;
+    pthread_t * threads;
+    char index[16];
+    int num_threads;
+    int i; //loop variable
+
+    if(!batch)                  PRINT_AND_RETURN("batch is NULL in run_batch",              GENERAL_ERROR);
+    if(!settings)               PRINT_AND_RETURN("settings is NULL in run_batch",           GENERAL_ERROR);
+
+    // Every family gets the shared settings and a prefix of its own
+    for(i = 0; i < batch->num_families; i++){
+        batch->families[i].symfrac      = settings->symfrac;
+        batch->families[i].band         = settings->band;
+        batch->families[i].check        = settings->check;
+        batch->families[i].num_threads  = settings->num_threads;
+        batch->families[i].num_jobs     = settings->num_jobs;
+        batch->families[i].cache        = settings->cache;
+        batch->families[i].resume       = settings->resume;
+        batch->status[i] = GENERAL_ERROR;
+        if(!prefix) continue;
+        sprintf(index, "%d", i);
+        free(batch->families[i].prefix);
+        batch->families[i].prefix = output_file_name(prefix, index);
+        if(!batch->families[i].prefix)
+                                PRINT_AND_RETURN("malloc failed for prefix in run_batch",   MALLOC_ERROR);
+    }
+
+    // Most expensive first, ties in manifest order. The size of the file stands for num_seq x N without parsing it,
+    // a file that cannot be read costs nothing and its family fails when it runs
+    for(i = 0; i < batch->num_families; i++)
+        batch->cost[i] = stat(batch->families[i].input_name, &info) == 0 ? (long) info.st_size : 0;
+    entries = malloc(batch->num_families * sizeof(batch_entry_t));
+    if(!entries)                PRINT_AND_RETURN("malloc failed for entries in run_batch",  MALLOC_ERROR);
+    for(i = 0; i < batch->num_families; i++) entries[i] = (batch_entry_t) { batch->cost[i], i };
+    qsort(entries, batch->num_families, sizeof(batch_entry_t), compare_cost);
+    for(i = 0; i < batch->num_families; i++) batch->order[i] = entries[i].index;
+    free(entries);
+
+    if(num_workers < 1) num_workers = 1;
+    if(num_workers > batch->num_families) num_workers = batch->num_families;
+    threads = malloc(num_workers * sizeof(pthread_t));
+    if(!threads)                PRINT_AND_RETURN("malloc failed for threads in run_batch",  MALLOC_ERROR);
+
+    batch->next = batch->done = 0;
+    for(num_threads = 0; num_threads < num_workers - 1; num_threads++)
+        if(pthread_create(&threads[num_threads], NULL, batch_worker, batch) != 0) break;
+    batch_worker(batch);
+    for(i = 0; i < num_threads; i++) pthread_join(threads[i], NULL);
+    free(threads);
+    return 0;
+}
+
+/* Write the results of the batch as tab separated values with a header, one line per family in the order of the
+ * manifest. The values of a family that failed are NA
+ * Input:   a batch that ran and the name of the results file
+ * Output:  0 on success, ERROR otherwise
+ * Effect:  write the results file
+ */
+int write_batch(batch_t * batch, char * results_name){
+    FILE * f;
+    family_t * family;
+    int i; //loop variable
+
+    if(!batch)                  PRINT_AND_RETURN("batch is NULL in write_batch",            GENERAL_ERROR);
+    f = fopen(results_name, "w");
+    if(!f)                      PRINT_AND_RETURN("cannot open results in write_batch",      OPEN_ERROR);
+
+    fprintf(f, "input\tnum_seq\tlength\tdelta_bic\tbest_bic\tdelta_aic\tbest_aic\tstatus\n");
+    for(i = 0; i < batch->num_families; i++){
+        family = &batch->families[i];
+        if(batch->status[i] != SUCCESS)
+            fprintf(f, "%s\tNA\tNA\tNA\tNA\tNA\tNA\tfailed\n", family->input_name);
+        else
+            fprintf(f, "%s\t%d\t%d\t%f\t%d\t%f\t%d\tok\n", family->input_name, family->num_seq, family->length,
+                    family->bic.delta, family->bic.best_model, family->aic.delta, family->aic.best_model);
+    }
+    if(fclose(f) != 0)          PRINT_AND_RETURN("cannot write results in write_batch",     OPEN_ERROR);
+    return 0;
+}
+
+
+//INTERNAL FUNCTIONS IMPLEMENTATIONS
+
+/* Add an alignment at the end of the batch
+ * Input:   the batch and the name of the alignment
+ * Output:  0 on success, ERROR otherwise
+ * Effect:  calls malloc or realloc, set fields in the batch
+ */
+int add_family(batch_t * batch, char * input_name){
+    family_t * families;
+    long * cost;
+    int * order, * status;
+    int capacity;
+
+    if(batch->num_families == batch->capacity){
+        capacity = batch->capacity ? 2 * batch->capacity : BATCH_INITIAL_CAPACITY;
+        families    = realloc(batch->families,  capacity * sizeof(family_t));
+        if(families)    batch->families = families;
+        cost        = realloc(batch->cost,      capacity * sizeof(long));
+        if(cost)        batch->cost = cost;
+        order       = realloc(batch->order,     capacity * sizeof(int));
+        if(order)       batch->order = order;
+        status      = realloc(batch->status,    capacity * sizeof(int));
+        if(status)      batch->status = status;
+        if(!families || !cost || !order || !status)
+                        PRINT_AND_RETURN("realloc failed in add_family",                MALLOC_ERROR);
+        batch->capacity = capacity;
+    }
+
+    batch->families[batch->num_families] = (family_t) { NULL };
+    batch->families[batch->num_families].input_name = malloc(strlen(input_name) + 1);
+    if(!batch->families[batch->num_families].input_name)
+                        PRINT_AND_RETURN("malloc failed for input name in add_family",  MALLOC_ERROR);
+    strcpy(batch->families[batch->num_families].input_name, input_name);
+    batch->status[batch->num_families] = GENERAL_ERROR;
+    batch->num_families++;
+    return 0;
+}
+
+/* Add every alignment named in a manifest, one per line
+ * Input:   the batch and the name of the manifest
+ * Output:  0 on success, ERROR otherwise
+ * Effect:  calls malloc, add families to the batch
+ */
+int read_manifest(batch_t * batch, char * name){
+    FILE * f;
+    char line[GENERAL_BUFFER_SIZE];
+    int length;
+
+    f = fopen(name, "r");
+    if(!f)              PRINT_AND_RETURN("cannot open manifest in read_manifest",       OPEN_ERROR);
+
+    while(fgets(line, GENERAL_BUFFER_SIZE, f)){
+        length = strlen(line);
+        while(length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r' || line[length - 1] == ' '))
+            line[--length] = 0;
+        if(strempty(line) || str_start_with(line, '#')) continue;
+        if(add_family(batch, line) != SUCCESS){
+            fclose(f);
+            PRINT_AND_RETURN("add family failed in read_manifest",                      GENERAL_ERROR);
+        }
+    }
+    fclose(f);
+    return 0;
+}
+
+/* Add every regular file of a directory, sorted by name so the results do not depend on the file system
+ * Input:   the batch and the name of the directory
+ * Output:  0 on success, ERROR otherwise
+ * Effect:  calls malloc, add families to the batch
+ */
+int read_directory(batch_t * batch, char * name){
+    DIR * dir;
+    struct dirent * entry;
+    struct stat info;
+    char path[GENERAL_BUFFER_SIZE];
+    int first;
+
+    dir = opendir(name);
+    if(!dir)            PRINT_AND_RETURN("cannot open directory in read_directory",     OPEN_ERROR);
+
+    first = batch->num_families;
+    while((entry = readdir(dir))){
+        if(str_start_with(entry->d_name, '.')) continue;
+        if(snprintf(path, GENERAL_BUFFER_SIZE, "%s/%s", name, entry->d_name) >= GENERAL_BUFFER_SIZE) continue;
+        if(stat(path, &info) != 0 || !S_ISREG(info.st_mode)) continue;
+        if(add_family(batch, path) != SUCCESS){
+            closedir(dir);
+            PRINT_AND_RETURN("add family failed in read_directory",                     GENERAL_ERROR);
+        }
+    }
+    closedir(dir);
+    qsort(batch->families + first, batch->num_families - first, sizeof(family_t), compare_input_name);
+
+    return 0;
+}
+
+// Order of the families of a directory
+int compare_input_name(const void * a, const void * b){
+    return strcmp(((family_t *) a)->input_name, ((family_t *) b)->input_name);
+}
+
+// Decreasing cost, then increasing index
+int compare_cost(const void * a, const void * b){
+    const batch_entry_t * x = a;
+    const batch_entry_t * y = b;
+
+    if(x->cost != y->cost) return x->cost > y->cost ? -1 : 1;
+    return x->index - y->index;
+}
+
+/* Loop of one thread of the pool: take the next family in order of cost and run it until none is left
+ * Input:   the batch
+ * Output:  NULL
+ * Effect:  run families, set fields in the batch
+ */
+void * batch_worker(void * arg){
+    batch_t * batch = arg;
+    int i;
+
+    pthread_mutex_lock(&batch->lock);
+    while(batch->next < batch->num_families){
+        i = batch->order[batch->next++];
+        pthread_mutex_unlock(&batch->lock);
+
+        batch->status[i] = run_family(&batch->families[i]);
+
+        pthread_mutex_lock(&batch->lock);
+        batch->done++;
+        printf("%s %s (%d of %d)\n", batch->families[i].input_name, batch->status[i] == SUCCESS ? "done" : "failed",
+               batch->done, batch->num_families);
+    }
+    pthread_mutex_unlock(&batch->lock);
+    return NULL;
+}
@@ -0,0 +1,37 @@
+// File in HMMDecompositionDecision, created by Thien Le in July 2018
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <pthread.h>
+
+#include "pipeline.h"
+
+// Many alignments run through the pipeline by one pool of threads, the most expensive ones first
+typedef struct batch {
+    int             num_families;   // number of alignments
+    int             capacity;       // number of families allocated
+    family_t*       families;       // the alignments, in the order of the manifest
+    long*           cost;           // estimated cost of each family (size of its file, about num_seq x N)
+    int*            order;          // families sorted by decreasing cost
+    int*            status;         // return value of run_family for each family
+    int             next;           // next entry of order handed to a thread
+    int             done;           // number of families finished
+    pthread_mutex_t lock;           // protects next and done while the batch runs
+} batch_t;
+
+// Constructor & destructor
+extern int init_batch(batch_t * batch);
+extern void destroy_batch(batch_t * batch);
+
+// Read the alignments from a manifest (one file per line) or from every regular file of a directory
+extern int read_batch(batch_t * batch, char * name);
+
+// Run every family with the given settings on num_workers threads, the intermediate files of each family are written
+// under prefix.<index> if prefix is set and stay in memory otherwise
+extern int run_batch(batch_t * batch, family_t * settings, char * prefix, int num_workers);
+
+// Write one line of results per family, in the order of the manifest
+extern int write_batch(batch_t * batch, char * results_name);
+
+#endif
@@ -0,0 +1,296 @@
+// File in HMMDecompositionDecision, created by Thien Le in July 2018
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "cache.h"
+#include "utilities.h"
+
+// Once over max_bytes, entries are removed until the cache is back under this fraction of it
+#define CACHE_LOW_WATER         0.9
+
+// Entry of the directory seen when evicting
+typedef struct cache_entry {
+    char    name[HASH_HEX_SIZE];
+    long    size;
+    double  used;           // modification time in seconds, set to the time of the last hit
+} cache_entry_t;
+
+// Private function templates
+int     write_whole_file        (char * filename, void * data, size_t length);
+int     cache_path              (cache_t * cache, char * key, char * path);
+long    evict_cache             (cache_t * cache, long limit);
+int     compare_used            (const void * a, const void * b);
+
+/* Constructor for the cache: create its directory if needed and measure the entries already in it
+ * Input:   pointer to the cache, its directory and the size the entries are kept under
+ * Output:  0 on success, ERROR otherwise
+ * Effect:  calls malloc, may create a directory, set fields in the cache, may remove entries
+ */
+int init_cache(cache_t * cache, char * dir, long max_bytes){
+    if(!cache)                  PRINT_AND_RETURN("cache is NULL in init_cache",             GENERAL_ERROR);
+    if(!dir)                    PRINT_AND_RETURN("dir is NULL in init_cache",               GENERAL_ERROR);
+    if(mkdir(dir, 0755) != 0 && errno != EEXIST)
+                                PRINT_AND_RETURN("cannot create directory in init_cache",   OPEN_ERROR);
+
+    cache->dir = malloc(strlen(dir) + 1);
+    if(!cache->dir)             PRINT_AND_RETURN("malloc failed in init_cache",             MALLOC_ERROR);
+    strcpy(cache->dir, dir);
+    if(pthread_mutex_init(&cache->lock, NULL) != 0){
+        free(cache->dir);
+        PRINT_AND_RETURN("cannot create lock in init_cache",                                GENERAL_ERROR);
+    }
+
+    cache->max_bytes = max_bytes;
+    cache->hits = cache->misses = cache->stores = cache->evictions = 0;
+    cache->bytes = evict_cache(cache, max_bytes);
+    return 0;
+}
+
+/* Destructor for the cache, the entries stay on disk
+ * Input:   pointer to the cache
+ * Output:  nothing
+ * Effect:  freeing mallocated blocks, destroy the lock of the cache
+ */
+void destroy_cache(cache_t * cache){
+    if(!cache || !cache->dir) return;
+    free(cache->dir);
+    pthread_mutex_destroy(&cache->lock);
+    cache->dir = NULL;
+}
+
+/* Read the entry of a key. A hit marks the entry as the most recently used
+ * Input:   the cache, the key and pointers to the buffer and its length
+ * Output:  0 on a hit, CACHE_MISS otherwise
+ * Effect:  calls malloc, set data and length, count the hit or miss
+ */
+int cache_get(cache_t * cache, char * key, char ** data, size_t * length){
+    char path[GENERAL_BUFFER_SIZE];
+    int status;
+
+    status = cache_path(cache, key, path) == SUCCESS && read_whole_file(path, data, length) == SUCCESS ? SUCCESS : CACHE_MISS;
+    if(status == SUCCESS) utimensat(AT_FDCWD, path, NULL, 0);
+
+    pthread_mutex_lock(&cache->lock);
+    if(status == SUCCESS)   cache->hits++;
+    else                    cache->misses++;
+    pthread_mutex_unlock(&cache->lock);
+    return status;
+}
+
+/* Store the entry of a key. The entry is written to a temporary file renamed to its name, so readers in other threads
+ * or processes see either no entry or all of it. The least recently used entries are removed if the cache grew too large
+ * Input:   the cache, the key, the data and its length
+ * Output:  0 on success, ERROR otherwise
+ * Effect:  write a file, may remove entries
+ */
+int cache_put(cache_t * cache, char * key, void * data, size_t length){
+    char path[GENERAL_BUFFER_SIZE];
+
+    if(cache_path(cache, key, path) != SUCCESS)
+                                PRINT_AND_RETURN("key too long in cache_put",               GENERAL_ERROR);
+    if(replace_file(path, data, length, 0) != SUCCESS)
+                                PRINT_AND_RETURN("cannot write entry in cache_put",         OPEN_ERROR);
+
+    pthread_mutex_lock(&cache->lock);
+    cache->stores++;
+    cache->bytes += length;
+    if(cache->bytes > cache->max_bytes) cache->bytes = evict_cache(cache, CACHE_LOW_WATER * cache->max_bytes);
+    pthread_mutex_unlock(&cache->lock);
+    return 0;
+}
+
+// Print the hits, misses, stores and evictions of the cache
+void print_cache(cache_t * cache){
+    pthread_mutex_lock(&cache->lock);
+    printf("Cache %s: %d hits, %d misses, %d stored, %d evicted, %ld bytes\n", cache->dir,
+           cache->hits, cache->misses, cache->stores, cache->evictions, cache->bytes);
+    pthread_mutex_unlock(&cache->lock);
+}
+
+// Copy the entry of a key to a file, CACHE_MISS without an entry
+int cache_get_file(cache_t * cache, char * key, char * filename){
+    char * data;
+    size_t length;
+    int status;
+
+    if(cache_get(cache, key, &data, &length) != SUCCESS) return CACHE_MISS;
+    status = write_whole_file(filename, data, length);
+    free(data);
+    if(status != SUCCESS)       PRINT_AND_RETURN("cannot write file in cache_get_file",     OPEN_ERROR);
+    return 0;
+}
+
+// Store a file as the entry of a key
+int cache_put_file(cache_t * cache, char * key, char * filename){
+    char * data;
+    size_t length;
+    int status;
+
+    if(read_whole_file(filename, &data, &length) != SUCCESS)
+                                PRINT_AND_RETURN("cannot read file in cache_put_file",      OPEN_ERROR);
+    status = cache_put(cache, key, data, length);
+    free(data);
+    return status;
+}
+
+/* Read a whole file into a mallocated buffer, null terminated
+ * Input:   the name of the file and pointers to the buffer and its length
+ * Output:  0 on success, ERROR otherwise
+ * Effect:  calls malloc, set data and length
+ */
+int read_whole_file(char * filename, char ** data, size_t * length){
+    struct stat info;
+    ssize_t n;
+    size_t done;
+    int fd;
+
+    fd = open(filename, O_RDONLY | O_CLOEXEC);
+    if(fd < 0) return OPEN_ERROR;
+    if(fstat(fd, &info) != 0 || !(*data = malloc(info.st_size + 1))){
+        close(fd);
+        return GENERAL_ERROR;
+    }
+    for(done = 0; done < (size_t) info.st_size; done += n){
+        n = read(fd, *data + done, info.st_size - done);
+        if(n < 0 && errno == EINTR){
+            n = 0;
+            continue;
+        }
+        if(n <= 0) break;
+    }
+    close(fd);
+    if(done != (size_t) info.st_size){
+        free(*data);
+        return GENERAL_ERROR;
+    }
+    (*data)[done] = 0;
+    *length = done;
+    return 0;
+}
+
+/* Replace a file by a buffer: the buffer is written to a temporary file in the same directory (named after the file,
+ * with a leading dot) renamed over the file, so the file is never seen half written. If durable, the data and then the
+ * rename are flushed to disk before returning, so the file survives a crash once this returns
+ * Input:   the name of the file, the data, its length and whether to flush it
+ * Output:  0 on success, ERROR otherwise
+ * Effect:  write a file
+ */
+int replace_file(char * filename, void * data, size_t length, int durable){
+    char temporary[GENERAL_BUFFER_SIZE];
+    char * base;
+    int fd, dir;
+
+    base = strrchr(filename, '/');
+    if(base)    snprintf(temporary, GENERAL_BUFFER_SIZE, "%.*s/.%s.XXXXXX", (int) (base - filename), filename, base + 1);
+    else        snprintf(temporary, GENERAL_BUFFER_SIZE, ".%s.XXXXXX", filename);
+    fd = mkstemp(temporary);
+    if(fd < 0) return OPEN_ERROR;
+    close(fd);
+
+    if(write_whole_file(temporary, data, length) != SUCCESS
+    || (durable && ((fd = open(temporary, O_RDONLY | O_CLOEXEC)) < 0 || fsync(fd) != 0 || close(fd) != 0))
+    || rename(temporary, filename) != 0){
+        unlink(temporary);
+        return GENERAL_ERROR;
+    }
+    if(durable){
+        if(base)    snprintf(temporary, GENERAL_BUFFER_SIZE, "%.*s", base == filename ? 1 : (int) (base - filename), filename);
+        else        strcpy(temporary, ".");
+        dir = open(temporary, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if(dir < 0 || fsync(dir) != 0){
+            if(dir >= 0) close(dir);
+            return GENERAL_ERROR;
+        }
+        close(dir);
+    }
+    return 0;
+}
+
+
+//INTERNAL FUNCTIONS IMPLEMENTATIONS
+
+// Replace the content of a file with a buffer
+int write_whole_file(char * filename, void * data, size_t length){
+    FILE * f;
+
+    f = fopen(filename, "w");
+    if(!f) return OPEN_ERROR;
+    if(fwrite(data, 1, length, f) != length){
+        fclose(f);
+        return GENERAL_ERROR;
+    }
+    return fclose(f) == 0 ? 0 : GENERAL_ERROR;
+}
+
+// Path of the entry of a key
+int cache_path(cache_t * cache, char * key, char * path){
+    if(snprintf(path, GENERAL_BUFFER_SIZE, "%s/%s", cache->dir, key) >= GENERAL_BUFFER_SIZE) return GENERAL_ERROR;
+    return 0;
+}
+
+/* Measure the entries of the cache and, if they take more than max_bytes, remove the least recently used ones until
+ * they take at most limit. Temporary files (starting with a dot) are left to their writer
+ * Input:   the cache, with its lock held if other threads use it, and the size to go down to
+ * Output:  the size of the entries left
+ * Effect:  calls malloc, may remove entries, count the evictions
+ */
+long evict_cache(cache_t * cache, long limit){
+    cache_entry_t * entries, * grown;
+    struct dirent * entry;
+    struct stat info;
+    char path[GENERAL_BUFFER_SIZE];
+    long total;
+    int num_entries, capacity;
+    DIR * dir;
+    int i; //loop variable
+
+    dir = opendir(cache->dir);
+    if(!dir) return 0;
+    entries = NULL;
+    num_entries = capacity = 0;
+    total = 0;
+    while((entry = readdir(dir))){
+        if(str_start_with(entry->d_name, '.') || strlen(entry->d_name) >= HASH_HEX_SIZE) continue;
+        if(cache_path(cache, entry->d_name, path) != SUCCESS || stat(path, &info) != 0 || !S_ISREG(info.st_mode)) continue;
+        if(num_entries == capacity){
+            capacity = capacity ? 2 * capacity : 64;
+            grown = realloc(entries, capacity * sizeof(cache_entry_t));
+            if(!grown) break;
+            entries = grown;
+        }
+        strcpy(entries[num_entries].name, entry->d_name);
+        entries[num_entries].size = info.st_size;
+        entries[num_entries].used = info.st_mtim.tv_sec + info.st_mtim.tv_nsec * 1e-9;
+        total += info.st_size;
+        num_entries++;
+    }
+    closedir(dir);
+
+    if(total > cache->max_bytes){
+        qsort(entries, num_entries, sizeof(cache_entry_t), compare_used);
+        for(i = 0; i < num_entries && total > limit; i++){
+            cache_path(cache, entries[i].name, path);
+            if(unlink(path) != 0) continue;
+            total -= entries[i].size;
+            cache->evictions++;
+        }
+    }
+    free(entries);
+    return total;
+}
+
+// Least recently used first, then by name
+int compare_used(const void * a, const void * b){
+    const cache_entry_t * x = a;
+    const cache_entry_t * y = b;
+
+    if(x->used != y->used) return x->used < y->used ? -1 : 1;
+    return strcmp(x->name, y->name);
+}
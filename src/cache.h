@@ -0,0 +1,44 @@
+// File in HMMDecompositionDecision, created by Thien Le in July 2018
+
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <stddef.h>
+#include <pthread.h>
+
+#include "hash.h"
+
+// Returned by cache_get when there is no entry for the key, not an error
+#define CACHE_MISS              1
+
+// Directory of artifacts named by the hash of everything they were computed from (content addressed), shared by every
+// thread and process using the directory. When it grows over max_bytes, the least recently used entries are removed
+typedef struct cache {
+    char*           dir;            // directory of the entries
+    long            max_bytes;      // size the entries are kept under
+    long            bytes;          // size of the entries when last measured plus the entries stored since
+    int             hits;           // number of cache_get that found their entry
+    int             misses;         // number of cache_get that did not
+    int             stores;         // number of entries stored
+    int             evictions;      // number of entries removed to keep the size under max_bytes
+    pthread_mutex_t lock;           // protects every field above but dir and max_bytes
+} cache_t;
+
+// Constructor & destructor, the constructor creates the directory if needed
+extern int init_cache(cache_t * cache, char * dir, long max_bytes);
+extern void destroy_cache(cache_t * cache);
+
+// Entries as buffers (mallocated by cache_get) or copied from and to files. cache_get returns CACHE_MISS without an entry
+extern int cache_get(cache_t * cache, char * key, char ** data, size_t * length);
+extern int cache_put(cache_t * cache, char * key, void * data, size_t length);
+extern int cache_get_file(cache_t * cache, char * key, char * filename);
+extern int cache_put_file(cache_t * cache, char * key, char * filename);
+
+// Print the statistics of the cache
+extern void print_cache(cache_t * cache);
+
+// Whole files as buffers. replace_file renames a temporary file over the file, flushed to disk first if durable
+extern int read_whole_file(char * filename, char ** data, size_t * length);
+extern int replace_file(char * filename, void * data, size_t length, int durable);
+
+#endif
@@ -0,0 +1,187 @@
+// File in HMMDecompositionDecision, created by Thien Le in July 2018
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "checkpoint.h"
+#include "cache.h"
+#include "options.h"
+#include "utilities.h"
+
+// Suffix of the manifest after the prefix of the run
+#define MANIFEST_SUFFIX         "manifest"
+
+// Private function templates
+int     read_manifest_file      (checkpoint_t * checkpoint);
+int     write_manifest          (checkpoint_t * checkpoint);
+
+/* Constructor for the checkpoints of a run. A new run writes an empty manifest right away so a manifest left by an
+ * earlier run with the same prefix is never mistaken for this one. A resumed run keeps the stages of the manifest if
+ * it was written for the same input and settings, and starts over otherwise
+ * Input:   pointer to the checkpoint, the prefix of the run, the hash of its input and settings, whether to resume
+ * Output:  0 on success, ERROR otherwise
+ * Effect:  calls malloc, set fields in the checkpoint, may write the manifest
+ */
+int init_checkpoint(checkpoint_t * checkpoint, char * prefix, char * run_key, int resume){
+    if(!checkpoint)             PRINT_AND_RETURN("checkpoint is NULL in init_checkpoint",       GENERAL_ERROR);
+    if(!prefix || !run_key)     PRINT_AND_RETURN("prefix or key is NULL in init_checkpoint",    GENERAL_ERROR);
+
+    checkpoint->manifest_name = output_file_name(prefix, MANIFEST_SUFFIX);
+    if(!checkpoint->manifest_name)
+                                PRINT_AND_RETURN("malloc failed in init_checkpoint",            MALLOC_ERROR);
+    if(pthread_mutex_init(&checkpoint->lock, NULL) != 0){
+        free(checkpoint->manifest_name);
+        PRINT_AND_RETURN("cannot create lock in init_checkpoint",                               GENERAL_ERROR);
+    }
+    strcpy(checkpoint->run_key, run_key);
+    checkpoint->num_stages = checkpoint->resumed = 0;
+
+    if(resume && read_manifest_file(checkpoint) == SUCCESS){
+        checkpoint->resumed = checkpoint->num_stages;
+        return 0;
+    }
+    if(resume) printf("No manifest of this run in %s, starting over\n", checkpoint->manifest_name);
+    checkpoint->num_stages = 0;
+    if(write_manifest(checkpoint) != SUCCESS){
+        destroy_checkpoint(checkpoint);
+        PRINT_AND_RETURN("cannot write manifest in init_checkpoint",                            OPEN_ERROR);
+    }
+    return 0;
+}
+
+/* Destructor for the checkpoints, the manifest stays on disk
+ * Input:   pointer to the checkpoint
+ * Output:  nothing
+ * Effect:  freeing mallocated blocks, destroy the lock
+ */
+void destroy_checkpoint(checkpoint_t * checkpoint){
+    if(!checkpoint || !checkpoint->manifest_name) return;
+    free(checkpoint->manifest_name);
+    pthread_mutex_destroy(&checkpoint->lock);
+    checkpoint->manifest_name = NULL;
+}
+
+/* Check whether a stage is complete: it is in the manifest and its file still has the checksum recorded
+ * Input:   the checkpoint, the name of the stage and its file
+ * Output:  0 if the stage is complete, CHECKPOINT_INCOMPLETE otherwise
+ * Effect:  read the file
+ */
+int checkpoint_done(checkpoint_t * checkpoint, char * stage, char * filename){
+    char recorded[HASH_HEX_SIZE], checksum[HASH_HEX_SIZE];
+    int found;
+    int i; //loop variable
+
+    found = 0;
+    pthread_mutex_lock(&checkpoint->lock);
+    for(i = 0; i < checkpoint->num_stages && !found; i++)
+        if(strcmp(checkpoint->stages[i].name, stage) == 0){
+            strcpy(recorded, checkpoint->stages[i].checksum);
+            found = 1;
+        }
+    pthread_mutex_unlock(&checkpoint->lock);
+    if(!found) return CHECKPOINT_INCOMPLETE;
+
+    if(hash_file(filename, checksum) == SUCCESS && strcmp(checksum, recorded) == 0) return 0;
+    printf("%s changed since it was recorded, running %s again\n", filename, stage);
+    return CHECKPOINT_INCOMPLETE;
+}
+
+/* Record a stage as complete. Its file is flushed to disk and hashed, then the manifest is replaced by one naming
+ * the stage and flushed too, so after a crash the manifest only names stages whose file is complete on disk
+ * Input:   the checkpoint, the name of the stage and its file
+ * Output:  0 on success, ERROR otherwise
+ * Effect:  flush the file, write the manifest
+ */
+int checkpoint_record(checkpoint_t * checkpoint, char * stage, char * filename){
+    char checksum[HASH_HEX_SIZE];
+    int fd, status;
+    int i; //loop variable
+
+    if(strlen(stage) >= CHECKPOINT_NAME_SIZE)
+                                PRINT_AND_RETURN("stage name too long in checkpoint_record",    GENERAL_ERROR);
+    fd = open(filename, O_RDONLY | O_CLOEXEC);
+    if(fd < 0 || fsync(fd) != 0){
+        if(fd >= 0) close(fd);
+        PRINT_AND_RETURN("cannot flush file in checkpoint_record",                              OPEN_ERROR);
+    }
+    close(fd);
+    if(hash_file(filename, checksum) != SUCCESS)
+                                PRINT_AND_RETURN("hash file failed in checkpoint_record",       GENERAL_ERROR);
+
+    pthread_mutex_lock(&checkpoint->lock);
+    for(i = 0; i < checkpoint->num_stages && strcmp(checkpoint->stages[i].name, stage) != 0; i++);
+    if(i == CHECKPOINT_MAX_STAGES){
+        pthread_mutex_unlock(&checkpoint->lock);
+        PRINT_AND_RETURN("too many stages in checkpoint_record",                                GENERAL_ERROR);
+    }
+    strcpy(checkpoint->stages[i].name, stage);
+    strcpy(checkpoint->stages[i].checksum, checksum);
+    if(i == checkpoint->num_stages) checkpoint->num_stages++;
+    status = write_manifest(checkpoint);
+    pthread_mutex_unlock(&checkpoint->lock);
+    if(status != SUCCESS)       PRINT_AND_RETURN("cannot write manifest in checkpoint_record",  OPEN_ERROR);
+    return 0;
+}
+
+
+//INTERNAL FUNCTIONS IMPLEMENTATIONS
+
+/* Read the stages of the manifest if it belongs to the same run
+ * Input:   the checkpoint with its manifest name and run key
+ * Output:  0 if the manifest was read, ERROR otherwise (no manifest, another run or an unreadable line)
+ * Effect:  set the stages of the checkpoint
+ */
+int read_manifest_file(checkpoint_t * checkpoint){
+    char * data, * line, * next, * name, * checksum;
+    size_t length;
+    int same_run;
+
+    if(read_whole_file(checkpoint->manifest_name, &data, &length) != SUCCESS) return OPEN_ERROR;
+
+    // The run line comes first, then one line per stage
+    checkpoint->num_stages = 0;
+    same_run = 0;
+    for(line = data; line && *line; line = next){
+        next = strchr(line, '\n');
+        if(next) *next++ = 0;
+
+        if(!same_run){
+            if(strncmp(line, "run\t", 4) != 0 || strcmp(line + 4, checkpoint->run_key) != 0) break;
+            same_run = 1;
+            continue;
+        }
+        if(strncmp(line, "stage\t", 6) != 0) break;
+        name = line + 6;
+        checksum = strchr(name, '\t');
+        if(!checksum || checksum - name >= CHECKPOINT_NAME_SIZE
+        || strlen(checksum + 1) != HASH_HEX_SIZE - 1 || checkpoint->num_stages == CHECKPOINT_MAX_STAGES) break;
+        *checksum++ = 0;
+        strcpy(checkpoint->stages[checkpoint->num_stages].name, name);
+        strcpy(checkpoint->stages[checkpoint->num_stages].checksum, checksum);
+        checkpoint->num_stages++;
+    }
+
+    // A manifest of another run, or with a line that cannot be read, is not used at all
+    if(!same_run || (line && *line)){
+        checkpoint->num_stages = 0;
+        free(data);
+        return GENERAL_ERROR;
+    }
+    free(data);
+    return 0;
+}
+
+// Replace the manifest by the stages recorded so far, flushed to disk
+int write_manifest(checkpoint_t * checkpoint){
+    char buffer[(CHECKPOINT_NAME_SIZE + HASH_HEX_SIZE + 8) * (CHECKPOINT_MAX_STAGES + 1)];
+    int length;
+    int i; //loop variable
+
+    length = sprintf(buffer, "run\t%s\n", checkpoint->run_key);
+    for(i = 0; i < checkpoint->num_stages; i++)
+        length += sprintf(buffer + length, "stage\t%s\t%s\n", checkpoint->stages[i].name, checkpoint->stages[i].checksum);
+    return replace_file(checkpoint->manifest_name, buffer, length, 1);
+}
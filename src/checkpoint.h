@@ -0,0 +1,50 @@
+// File in HMMDecompositionDecision, created by Thien Le in July 2018
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <pthread.h>
+
+#include "hash.h"
+
+// Largest number of stages recorded for one run and longest stage name
+#define CHECKPOINT_MAX_STAGES   16
+#define CHECKPOINT_NAME_SIZE    64
+
+// Returned by checkpoint_done when a stage has to run, not an error
+#define CHECKPOINT_INCOMPLETE   1
+
+// Stage of a run recorded as complete, with the checksum of the file it left (named after the stage by the pipeline)
+typedef struct checkpoint_stage {
+    char    name[CHECKPOINT_NAME_SIZE];
+    char    checksum[HASH_HEX_SIZE];
+} checkpoint_stage_t;
+
+/* Manifest of a run written next to its intermediate files (<prefix>.manifest), rewritten atomically and flushed to disk
+ * every time a stage completes:
+ *      run <hash of the input and of the settings>
+ *      stage <name> <sha256 of its file>
+ * with tabs between the fields
+ * A run resumed with the same input and settings skips every stage whose file still has its checksum
+ */
+typedef struct checkpoint {
+    char*               manifest_name;  // <prefix>.manifest
+    char                run_key[HASH_HEX_SIZE];     // hash of the input and of the settings of the run
+    int                 num_stages;     // number of stages complete
+    checkpoint_stage_t  stages[CHECKPOINT_MAX_STAGES];
+    int                 resumed;        // number of stages found complete when resuming
+    pthread_mutex_t     lock;           // protects the stages and the manifest
+} checkpoint_t;
+
+// Constructor & destructor. The constructor starts a new manifest, or reads the one of the prefix when resuming
+// and it belongs to the same run
+extern int init_checkpoint(checkpoint_t * checkpoint, char * prefix, char * run_key, int resume);
+extern void destroy_checkpoint(checkpoint_t * checkpoint);
+
+// Whether a stage is complete and its file unchanged (SUCCESS) or has to run (CHECKPOINT_INCOMPLETE)
+extern int checkpoint_done(checkpoint_t * checkpoint, char * stage, char * filename);
+
+// Record a stage as complete once its file is written, the file is flushed to disk before the manifest names it
+extern int checkpoint_record(checkpoint_t * checkpoint, char * stage, char * filename);
+
+#endif
@@ -0,0 +1,132 @@
+// File in HMMDecompositionDecision, created by Thien Le in July 2018
+
+#include <stdio.h>
+#include <string.h>
+
+#include "hash.h"
+#include "utilities.h"
+
+// Bytes read from a file at a time
+#define HASH_CHUNK_SIZE         65536
+
+#define ROTATE(x, n)            (((x) >> (n)) | ((x) << (32 - (n))))
+
+// Round constants of SHA-256 (FIPS 180-4)
+static const uint32_t round_constant[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+// Private function templates
+void    compress_block          (hash_t * hash, const uint8_t * block);
+
+// Start a hash with the initial value of SHA-256
+void init_hash(hash_t * hash){
+    static const uint32_t initial[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+
+    memcpy(hash->state, initial, sizeof(initial));
+    hash->length = 0;
+}
+
+// Feed bytes to a hash, full blocks are compressed as soon as they are complete
+void update_hash(hash_t * hash, const void * data, size_t length){
+    const uint8_t * bytes = data;
+    size_t used, taken;
+
+    while(length > 0){
+        used = hash->length % 64;
+        taken = 64 - used < length ? 64 - used : length;
+        if(used == 0 && length >= 64){
+            compress_block(hash, bytes);
+            taken = 64;
+        } else{
+            memcpy(hash->block + used, bytes, taken);
+            if(used + taken == 64) compress_block(hash, hash->block);
+        }
+        hash->length += taken;
+        bytes += taken;
+        length -= taken;
+    }
+}
+
+// Pad the last block with the length in bits and write the digest as 64 hexadecimal digits
+void final_hash(hash_t * hash, char * hex){
+    uint8_t padding[72];
+    uint64_t bits;
+    size_t used, pad;
+    int i; //loop variable
+
+    bits = hash->length * 8;
+    used = hash->length % 64;
+    pad = used < 56 ? 56 - used : 120 - used;
+    memset(padding, 0, sizeof(padding));
+    padding[0] = 0x80;
+    for(i = 0; i < 8; i++) padding[pad + i] = bits >> (56 - 8 * i);
+    update_hash(hash, padding, pad + 8);
+
+    for(i = 0; i < 8; i++) sprintf(hex + 8 * i, "%08x", hash->state[i]);
+}
+
+void update_hash_string(hash_t * hash, const char * string){
+    if(!string) string = "";
+    update_hash(hash, string, strlen(string) + 1);
+}
+
+/* Hash of the bytes of a file
+ * Input:   the name of the file and room for HASH_HEX_SIZE characters
+ * Output:  0 on success, ERROR otherwise
+ * Effect:  read the file, set hex
+ */
+int hash_file(char * filename, char * hex){
+    char chunk[HASH_CHUNK_SIZE];
+    hash_t hash;
+    FILE * f;
+    size_t n;
+
+    f = fopen(filename, "r");
+    if(!f)              PRINT_AND_RETURN("cannot open file in hash_file",           OPEN_ERROR);
+    init_hash(&hash);
+    while((n = fread(chunk, 1, HASH_CHUNK_SIZE, f)) > 0) update_hash(&hash, chunk, n);
+    if(ferror(f)){
+        fclose(f);
+        PRINT_AND_RETURN("cannot read file in hash_file",                           OPEN_ERROR);
+    }
+    fclose(f);
+    final_hash(&hash, hex);
+    return 0;
+}
+
+
+//INTERNAL FUNCTIONS IMPLEMENTATIONS
+
+// SHA-256 compression of one 64 byte block into the chaining value
+void compress_block(hash_t * hash, const uint8_t * block){
+    uint32_t w[64];
+    uint32_t a, b, c, d, e, f, g, h, t1, t2;
+    int i; //loop variable
+
+    for(i = 0; i < 16; i++)
+        w[i] = (uint32_t) block[4 * i] << 24 | (uint32_t) block[4 * i + 1] << 16 | (uint32_t) block[4 * i + 2] << 8 | block[4 * i + 3];
+    for(i = 16; i < 64; i++)
+        w[i] = w[i - 16] + (ROTATE(w[i - 15], 7) ^ ROTATE(w[i - 15], 18) ^ (w[i - 15] >> 3))
+             + w[i - 7] + (ROTATE(w[i - 2], 17) ^ ROTATE(w[i - 2], 19) ^ (w[i - 2] >> 10));
+
+    a = hash->state[0]; b = hash->state[1]; c = hash->state[2]; d = hash->state[3];
+    e = hash->state[4]; f = hash->state[5]; g = hash->state[6]; h = hash->state[7];
+    for(i = 0; i < 64; i++){
+        t1 = h + (ROTATE(e, 6) ^ ROTATE(e, 11) ^ ROTATE(e, 25)) + ((e & f) ^ (~e & g)) + round_constant[i] + w[i];
+        t2 = (ROTATE(a, 2) ^ ROTATE(a, 13) ^ ROTATE(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+    hash->state[0] += a; hash->state[1] += b; hash->state[2] += c; hash->state[3] += d;
+    hash->state[4] += e; hash->state[5] += f; hash->state[6] += g; hash->state[7] += h;
+}
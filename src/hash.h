@@ -0,0 +1,31 @@
+// File in HMMDecompositionDecision, created by Thien Le in July 2018
+
+#ifndef HASH_H
+#define HASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Size of a SHA-256 digest and of its hexadecimal form with the null terminator
+#define HASH_SIZE               32
+#define HASH_HEX_SIZE           (2 * HASH_SIZE + 1)
+
+// SHA-256 of a stream of bytes fed by pieces
+typedef struct hash {
+    uint32_t    state[8];       // chaining value
+    uint64_t    length;         // number of bytes hashed so far
+    uint8_t     block[64];      // bytes waiting for a full block
+} hash_t;
+
+// Start, feed and finish a hash, the digest is written in hexadecimal
+extern void init_hash(hash_t * hash);
+extern void update_hash(hash_t * hash, const void * data, size_t length);
+extern void final_hash(hash_t * hash, char * hex);
+
+// Feed a string with its null terminator so consecutive strings cannot run into each other, NULL counts as ""
+extern void update_hash_string(hash_t * hash, const char * string);
+
+// Hash of a whole file, ERROR if it cannot be read
+extern int hash_file(char * filename, char * hex);
+
+#endif
@@ -0,0 +1,630 @@
+// File in HMMDecompositionDecision, created by Thien Le in July 2018
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+
+#include "hmm.h"
+#include "utilities.h"
+
+// Single component Dirichlet priors. The transition priors are the ones hmmbuild uses for nucleotides
+#define PRIOR_TMM               2.0
+#define PRIOR_TMI               0.1
+#define PRIOR_TMD               0.1
+#define PRIOR_TIM               0.06
+#define PRIOR_TII               0.2
+#define PRIOR_TDM               0.1
+#define PRIOR_TDD               0.2
+#define PRIOR_MATCH             1.0
+
+// Entropy weighting targets (as in hmmbuild for nucleotides): mean relative entropy per match state in bits
+// and the minimum total information content in bits the model should keep
+#define TARGET_RELATIVE_ENTROPY 0.62
+#define TARGET_SIGMA            45.0
+#define MAX_BISECTION           50
+
+// Emission probability above which the consensus residue is printed in upper case
+#define CONSENSUS_THRESHOLD     0.9
+
+// Background frequency of every nucleotide
+#define BACKGROUND              (1.0 / HMM_ALPHABET_SIZE)
+
+// Private function templates
+int     sequence_weights        (msa_t * msa, float * weight);
+int     assign_match_columns    (msa_t * msa, float * weight, float symfrac, int * column_node);
+void    count_trace             (trace_t * trace, int M, float weight, double * tcount, double * mcount);
+double  match_relative_entropy  (double * mcount, int M, double scale);
+float   entropy_weight          (double * mcount, int M, int num_seq);
+void    estimate_parameters     (hmm_t * hmm, double * tcount, double * mcount, double scale);
+void    write_probability       (FILE * f, float p);
+
+/* Constructor for the hmm, the model is empty until build_hmm is called
+ * Input:   pointer to the hmm
+ * Output:  0 on success, ERROR otherwise
+ * Effect:  set fields in the hmm
+ */
+int init_hmm(hmm_t * hmm){
+    if(!hmm)        PRINT_AND_RETURN("hmm is NULL in init_hmm",     GENERAL_ERROR);
+
+    hmm->M              = 0;
+    hmm->num_seq        = 0;
+    hmm->eff_num_seq    = 0;
+    hmm->t              = NULL;
+    hmm->mat            = NULL;
+    hmm->ins            = NULL;
+    hmm->map            = NULL;
+    hmm->consensus      = NULL;
+    return 0;
+}
+
+/* Destructor for the hmm that frees all mallocated fields
+ * This does not deallocate the struct itself if the struct was from heap memory
+ * Input:   pointer to the hmm
+ * Output:  nothing
+ * Effect:  freeing mallocated blocks
+ */
+void destroy_hmm(hmm_t * hmm){
+    if(!hmm) return;
+
+    free(hmm->t);
+    free(hmm->mat);
+    free(hmm->ins);
+    free(hmm->map);
+    free(hmm->consensus);
+    init_hmm(hmm);
+}
+
+/* Build a profile HMM from an alignment the way hmmbuild does for nucleotides:
+ * sequences are weighted by Henikoff position-based weights, a column is a match column if the weighted fraction of residues in it
+ * is at least symfrac, every sequence is traced through the model to count transitions and match emissions, the counts are scaled
+ * down to an effective number of sequences by entropy weighting and the parameters are the mean posterior under Dirichlet priors
+ * Residues before the first and after the last match column are left out, as they are emitted by flanking states in a local alignment
+ * Input:   an initialized hmm, the msa (owning or a view) and the symfrac threshold
+ * Output:  0 on success, ERROR otherwise
+ * Effect:  calls malloc, set fields in the hmm
+ */
+int build_hmm(hmm_t * hmm, msa_t * msa, float symfrac){
+    float * weight;         // weight of each sequence
+    int * column_node;      // node of each match column, 0 for insert columns
+    double * tcount;        // weighted transition counts
+    double * mcount;        // weighted match emission counts
+    trace_t trace;          // path of the current sequence
+    int M, N, i, c;         // loop variables
+
+    if(!hmm)                PRINT_AND_RETURN("hmm is NULL in build_hmm",            GENERAL_ERROR);
+    if(!msa)                PRINT_AND_RETURN("msa is NULL in build_hmm",            GENERAL_ERROR);
+    if(msa->num_seq < 1)    PRINT_AND_RETURN("msa is empty in build_hmm",           GENERAL_ERROR);
+    destroy_hmm(hmm);
+
+    N = msa->N;
+    weight          = malloc(msa->num_seq * sizeof(float));
+    column_node     = malloc((N + 1) * sizeof(int));
+    trace.state     = malloc((N + 1) * sizeof(char));
+    trace.node      = malloc((N + 1) * sizeof(int));
+    trace.residue   = malloc((N + 1) * sizeof(int));
+    tcount = mcount = NULL;
+    if(!weight || !column_node || !trace.state || !trace.node || !trace.residue){
+        free(weight); free(column_node); free(trace.state); free(trace.node); free(trace.residue);
+        PRINT_AND_RETURN("malloc failed in build_hmm",                              MALLOC_ERROR);
+    }
+
+    // Weight the sequences and pick the match columns
+    if(sequence_weights(msa, weight) != SUCCESS)
+        goto fail;
+    M = assign_match_columns(msa, weight, symfrac, column_node);
+    if(M < 1){
+        printf("no match column in build_hmm\n");
+        goto fail;
+    }
+
+    // Allocate the model
+    hmm->M          = M;
+    hmm->num_seq    = msa->num_seq;
+    hmm->t          = malloc((M + 1) * HMM_NUM_TRANSITIONS * sizeof(float));
+    hmm->mat        = malloc((M + 1) * HMM_ALPHABET_SIZE * sizeof(float));
+    hmm->ins        = malloc((M + 1) * HMM_ALPHABET_SIZE * sizeof(float));
+    hmm->map        = malloc((M + 1) * sizeof(int));
+    hmm->consensus  = malloc((M + 2) * sizeof(char));
+    tcount          = calloc((M + 1) * HMM_NUM_TRANSITIONS, sizeof(double));
+    mcount          = calloc((M + 1) * HMM_ALPHABET_SIZE, sizeof(double));
+    if(!hmm->t || !hmm->mat || !hmm->ins || !hmm->map || !hmm->consensus || !tcount || !mcount){
+        printf("malloc failed for the model in build_hmm\n");
+        goto fail;
+    }
+    for(c = 0; c < N; c++)
+        if(column_node[c]) hmm->map[column_node[c]] = c + 1;
+
+    // Count the path of every sequence
+    for(i = 0; i < msa->num_seq; i++){
+        trace_sequence(msa_sequence(msa, i), N, M, column_node, &trace);
+        doctor_trace(&trace);
+        count_trace(&trace, M, weight[i], tcount, mcount);
+    }
+
+    // Counts sum to num_seq per node, scale them to the effective number of sequences
+    hmm->eff_num_seq = entropy_weight(mcount, M, msa->num_seq);
+    estimate_parameters(hmm, tcount, mcount, hmm->eff_num_seq / msa->num_seq);
+
+    free(weight); free(column_node); free(trace.state); free(trace.node); free(trace.residue);
+    free(tcount); free(mcount);
+    return 0;
+
+fail:
+    free(weight); free(column_node); free(trace.state); free(trace.node); free(trace.residue);
+    free(tcount); free(mcount);
+    destroy_hmm(hmm);
+    return GENERAL_ERROR;
+}
+
+/* Write the model in the HMMER3/f text format so it can be read by hmmsearch
+ * The model is not calibrated: the STATS lines hold a rough location and the lambda hmmbuild would use, so E-values computed from
+ * this file are not meaningful. The pipeline only uses bit scores (hmmsearch runs with -E Infinity)
+ * Input:   the hmm and the name of the file
+ * Output:  0 on success, ERROR otherwise
+ * Effect:  open and write a file
+ */
+int write_hmm(hmm_t * hmm, char * filename){
+    FILE * f;
+    float compo[HMM_ALPHABET_SIZE];     // mean match emission
+    double relative_entropy, lambda;
+    int k, x, s;                        // loop variables
+
+    if(!hmm)            PRINT_AND_RETURN("hmm is NULL in write_hmm",                GENERAL_ERROR);
+    if(!filename)       PRINT_AND_RETURN("filename is NULL in write_hmm",           GENERAL_ERROR);
+    if(hmm->M < 1)      PRINT_AND_RETURN("hmm is not built in write_hmm",           GENERAL_ERROR);
+
+    f = fopen(filename, "w");
+    if(!f)              PRINT_AND_RETURN("cannot open file to write in write_hmm",  OPEN_ERROR);
+
+    // Composition and mean relative entropy of the match states
+    relative_entropy = 0;
+    for(x = 0; x < HMM_ALPHABET_SIZE; x++) compo[x] = 0;
+    for(k = 1; k <= hmm->M; k++)
+        for(x = 0; x < HMM_ALPHABET_SIZE; x++){
+            compo[x] += hmm_match(hmm, k, x) / hmm->M;
+            if(hmm_match(hmm, k, x) > 0)
+                relative_entropy += hmm_match(hmm, k, x) * log2(hmm_match(hmm, k, x) / BACKGROUND) / hmm->M;
+        }
+    lambda = log(2.0) + 1.44 / (hmm->M * relative_entropy);
+
+    // Header
+    fprintf(f, "HMMER3/f [3.1b2 | February 2015]\n");
+    fprintf(f, "NAME  %s\n", filename);
+    fprintf(f, "LENG  %d\n", hmm->M);
+    fprintf(f, "ALPH  DNA\n");
+    fprintf(f, "RF    no\n");
+    fprintf(f, "MM    no\n");
+    fprintf(f, "CONS  yes\n");
+    fprintf(f, "CS    no\n");
+    fprintf(f, "MAP   yes\n");
+    fprintf(f, "NSEQ  %d\n", hmm->num_seq);
+    fprintf(f, "EFFN  %f\n", hmm->eff_num_seq);
+    fprintf(f, "STATS LOCAL MSV      %8.4f %8.5f\n", -log2(hmm->M) - 4.0, lambda);
+    fprintf(f, "STATS LOCAL VITERBI  %8.4f %8.5f\n", -log2(hmm->M) - 5.0, lambda);
+    fprintf(f, "STATS LOCAL FORWARD  %8.4f %8.5f\n", -4.0, lambda);
+    fprintf(f, "HMM     ");
+    for(x = 0; x < HMM_ALPHABET_SIZE; x++) fprintf(f, "     %c   ", "ACGT"[x]);
+    fprintf(f, "\n        %8s %8s %8s %8s %8s %8s %8s\n", "m->m", "m->i", "m->d", "i->m", "i->i", "d->m", "d->d");
+
+    // Node 0
+    fprintf(f, "  COMPO ");
+    for(x = 0; x < HMM_ALPHABET_SIZE; x++)      write_probability(f, compo[x]);
+    fprintf(f, "\n        ");
+    for(x = 0; x < HMM_ALPHABET_SIZE; x++)      write_probability(f, hmm_insert(hmm, 0, x));
+    fprintf(f, "\n        ");
+    for(s = 0; s < HMM_NUM_TRANSITIONS; s++)    write_probability(f, hmm_transition(hmm, 0, s));
+    fprintf(f, "\n");
+
+    // Nodes 1 to M, followed by the map, consensus, rf, mm and cs annotations
+    for(k = 1; k <= hmm->M; k++){
+        fprintf(f, " %6d ", k);
+        for(x = 0; x < HMM_ALPHABET_SIZE; x++)      write_probability(f, hmm_match(hmm, k, x));
+        fprintf(f, " %6d %c - - -\n        ", hmm->map[k], hmm->consensus[k]);
+        for(x = 0; x < HMM_ALPHABET_SIZE; x++)      write_probability(f, hmm_insert(hmm, k, x));
+        fprintf(f, "\n        ");
+        for(s = 0; s < HMM_NUM_TRANSITIONS; s++)    write_probability(f, hmm_transition(hmm, k, s));
+        fprintf(f, "\n");
+    }
+    fprintf(f, "//\n");
+
+    if(fclose(f) != 0)  PRINT_AND_RETURN("cannot write file in write_hmm",         GENERAL_ERROR);
+    return 0;
+}
+
+/* Copy the model into one buffer, in the layout of the fields: M, num_seq, eff_num_seq, t, mat, ins, map and consensus
+ * The buffer holds native numbers and is only meant to be read back by unpack_hmm on the same machine
+ * Input:   the hmm, pointers to the buffer and its length
+ * Output:  0 on success, ERROR otherwise
+ * Effect:  calls malloc, set buffer and length
+ */
+int pack_hmm(hmm_t * hmm, char ** buffer, size_t * length){
+    size_t M1;
+    char * p;
+
+    if(!hmm || hmm->M < 1)  PRINT_AND_RETURN("hmm is not built in pack_hmm",            GENERAL_ERROR);
+
+    M1 = hmm->M + 1;
+    *length = 2 * sizeof(int) + sizeof(float) + M1 * (HMM_NUM_TRANSITIONS + 2 * HMM_ALPHABET_SIZE) * sizeof(float)
+            + M1 * sizeof(int) + M1 + 1;
+    *buffer = p = malloc(*length);
+    if(!p)                  PRINT_AND_RETURN("malloc failed in pack_hmm",               MALLOC_ERROR);
+
+    memcpy(p, &hmm->M, sizeof(int));                                    p += sizeof(int);
+    memcpy(p, &hmm->num_seq, sizeof(int));                              p += sizeof(int);
+    memcpy(p, &hmm->eff_num_seq, sizeof(float));                        p += sizeof(float);
+    memcpy(p, hmm->t, M1 * HMM_NUM_TRANSITIONS * sizeof(float));        p += M1 * HMM_NUM_TRANSITIONS * sizeof(float);
+    memcpy(p, hmm->mat, M1 * HMM_ALPHABET_SIZE * sizeof(float));        p += M1 * HMM_ALPHABET_SIZE * sizeof(float);
+    memcpy(p, hmm->ins, M1 * HMM_ALPHABET_SIZE * sizeof(float));        p += M1 * HMM_ALPHABET_SIZE * sizeof(float);
+    memcpy(p, hmm->map, M1 * sizeof(int));                              p += M1 * sizeof(int);
+    memcpy(p, hmm->consensus, M1 + 1);
+    return 0;
+}
+
+/* Read back a model copied by pack_hmm
+ * Input:   an initialized hmm, the buffer and its length
+ * Output:  0 on success, ERROR otherwise (a buffer that does not hold a model)
+ * Effect:  calls malloc, set fields in the hmm
+ */
+int unpack_hmm(hmm_t * hmm, char * buffer, size_t length){
+    size_t M1;
+    int M;
+
+    if(!hmm)                PRINT_AND_RETURN("hmm is NULL in unpack_hmm",               GENERAL_ERROR);
+    if(!buffer || length < sizeof(int))
+                            PRINT_AND_RETURN("buffer too short in unpack_hmm",          GENERAL_ERROR);
+    memcpy(&M, buffer, sizeof(int));
+    M1 = M + 1;
+    if(M < 1 || length != 2 * sizeof(int) + sizeof(float) + M1 * (HMM_NUM_TRANSITIONS + 2 * HMM_ALPHABET_SIZE) * sizeof(float)
+                          + M1 * sizeof(int) + M1 + 1)
+                            PRINT_AND_RETURN("buffer does not hold a model in unpack_hmm",  GENERAL_ERROR);
+    destroy_hmm(hmm);
+
+    hmm->t          = malloc(M1 * HMM_NUM_TRANSITIONS * sizeof(float));
+    hmm->mat        = malloc(M1 * HMM_ALPHABET_SIZE * sizeof(float));
+    hmm->ins        = malloc(M1 * HMM_ALPHABET_SIZE * sizeof(float));
+    hmm->map        = malloc(M1 * sizeof(int));
+    hmm->consensus  = malloc(M1 + 1);
+    if(!hmm->t || !hmm->mat || !hmm->ins || !hmm->map || !hmm->consensus){
+        destroy_hmm(hmm);
+        PRINT_AND_RETURN("malloc failed in unpack_hmm",                                 MALLOC_ERROR);
+    }
+
+    hmm->M = M;                                                         buffer += sizeof(int);
+    memcpy(&hmm->num_seq, buffer, sizeof(int));                         buffer += sizeof(int);
+    memcpy(&hmm->eff_num_seq, buffer, sizeof(float));                   buffer += sizeof(float);
+    memcpy(hmm->t, buffer, M1 * HMM_NUM_TRANSITIONS * sizeof(float));   buffer += M1 * HMM_NUM_TRANSITIONS * sizeof(float);
+    memcpy(hmm->mat, buffer, M1 * HMM_ALPHABET_SIZE * sizeof(float));   buffer += M1 * HMM_ALPHABET_SIZE * sizeof(float);
+    memcpy(hmm->ins, buffer, M1 * HMM_ALPHABET_SIZE * sizeof(float));   buffer += M1 * HMM_ALPHABET_SIZE * sizeof(float);
+    memcpy(hmm->map, buffer, M1 * sizeof(int));                         buffer += M1 * sizeof(int);
+    memcpy(hmm->consensus, buffer, M1 + 1);
+    hmm->consensus[M1] = 0;
+    return 0;
+}
+
+/* Number of free parameters of a model. Following the conventions of hmmer.h:
+ *   t[0][TMM, TMI, TMD] are the begin transitions and delete state 0 does not exist, so node 0 has 1 free transition parameter
+ *   (the I_0 transitions are fixed by the prior since no residue is ever emitted by I_0),
+ *   each of the next M - 1 nodes has 2 free transition parameters and the end node has none
+ *   Insert emissions are set to the background, each match state has 3 free emission parameters for the 4 nucleotides
+ * Thus the total number of free parameters is 2 * M - 1 + 3 * M = 5 * M - 1
+ * Input:   the hmm
+ * Output:  the number of free parameters
+ * Effect:  none
+ */
+int hmm_num_parameters(hmm_t * hmm){
+    return 5 * hmm->M - 1;
+}
+
+
+/* Encode a residue as the set of nucleotides it stands for, one bit per nucleotide in the order A, C, G, T
+ * Input:   a character of the alignment
+ * Output:  the set of nucleotides, 0 for a gap, all 4 for unknown letters
+ * Effect:  none
+ */
+int residue_code(char c){
+    switch(toupper((unsigned char) c)){
+        case 'A':   return 1;
+        case 'C':   return 2;
+        case 'G':   return 4;
+        case 'T':
+        case 'U':   return 8;
+        case 'R':   return 1 | 4;
+        case 'Y':   return 2 | 8;
+        case 'S':   return 2 | 4;
+        case 'W':   return 1 | 8;
+        case 'K':   return 4 | 8;
+        case 'M':   return 1 | 2;
+        case 'B':   return 2 | 4 | 8;
+        case 'D':   return 1 | 4 | 8;
+        case 'H':   return 1 | 2 | 8;
+        case 'V':   return 1 | 2 | 4;
+        default:    return isalpha((unsigned char) c) ? 15 : 0;
+    }
+}
+
+
+//INTERNAL FUNCTIONS IMPLEMENTATIONS
+
+/* Henikoff position-based weights: a sequence gets 1 / (r * n) for every residue it has in a column with r different residues
+ * n of which are the same as its own, divided by its number of residues. Only the 4 nucleotides count, the weights sum to num_seq
+ * Input:   the msa and an array of num_seq weights
+ * Output:  0 on success, ERROR otherwise
+ * Effect:  calls malloc, set the weights
+ */
+int sequence_weights(msa_t * msa, float * weight){
+    int * count;        // number of sequences with each nucleotide in each column
+    int * distinct;     // number of different nucleotides in each column
+    char * sequence;
+    double total;
+    int i, c, x, code, length;
+
+    count = calloc((size_t) msa->N * HMM_ALPHABET_SIZE, sizeof(int));
+    distinct = calloc(msa->N, sizeof(int));
+    if(!count || !distinct){
+        free(count); free(distinct);
+        PRINT_AND_RETURN("malloc failed in sequence_weights",                       MALLOC_ERROR);
+    }
+
+    // Count the nucleotides of every column, row by row
+    for(i = 0; i < msa->num_seq; i++){
+        sequence = msa_sequence(msa, i);
+        for(c = 0; c < msa->N && sequence[c]; c++)
+            switch(residue_code(sequence[c])){
+                case 1: count[c * HMM_ALPHABET_SIZE + 0]++; break;
+                case 2: count[c * HMM_ALPHABET_SIZE + 1]++; break;
+                case 4: count[c * HMM_ALPHABET_SIZE + 2]++; break;
+                case 8: count[c * HMM_ALPHABET_SIZE + 3]++; break;
+            }
+    }
+    for(c = 0; c < msa->N; c++)
+        for(x = 0; x < HMM_ALPHABET_SIZE; x++)
+            if(count[c * HMM_ALPHABET_SIZE + x]) distinct[c]++;
+
+    // Weight of every sequence
+    total = 0;
+    for(i = 0; i < msa->num_seq; i++){
+        sequence = msa_sequence(msa, i);
+        weight[i] = 0;
+        length = 0;
+        for(c = 0; c < msa->N && sequence[c]; c++){
+            code = residue_code(sequence[c]);
+            if(code != 1 && code != 2 && code != 4 && code != 8) continue;
+            x = code == 1 ? 0 : code == 2 ? 1 : code == 4 ? 2 : 3;
+            weight[i] += 1.0 / (distinct[c] * count[c * HMM_ALPHABET_SIZE + x]);
+            length++;
+        }
+        if(length) weight[i] /= length;
+        total += weight[i];
+    }
+
+    // Normalize to sum to the number of sequences, sequences without any nucleotide all get weight 1
+    for(i = 0; i < msa->num_seq; i++)
+        weight[i] = total > 0 ? weight[i] * msa->num_seq / total : 1.0;
+
+    free(count);
+    free(distinct);
+    return 0;
+}
+
+/* A column is a match column if the weighted fraction of sequences with a residue in it is at least symfrac (and not 0)
+ * Input:   the msa, the sequence weights, the threshold and an array of N nodes
+ * Output:  the number of match columns
+ * Effect:  calls malloc, set the node of every match column (starting at 1) and 0 for the insert columns
+ */
+int assign_match_columns(msa_t * msa, float * weight, float symfrac, int * column_node){
+    double * residues;  // weighted number of residues in each column
+    double total;       // sum of the weights
+    char * sequence;
+    int i, c, M;
+
+    residues = calloc(msa->N, sizeof(double));
+    if(!residues)       PRINT_AND_RETURN("malloc failed in assign_match_columns",   0);
+
+    total = 0;
+    for(i = 0; i < msa->num_seq; i++){
+        sequence = msa_sequence(msa, i);
+        for(c = 0; c < msa->N && sequence[c]; c++)
+            if(residue_code(sequence[c])) residues[c] += weight[i];
+        total += weight[i];
+    }
+
+    M = 0;
+    for(c = 0; c < msa->N; c++)
+        column_node[c] = residues[c] > 0 && residues[c] >= symfrac * total ? ++M : 0;
+
+    free(residues);
+    return M;
+}
+
+/* Path of a sequence through the model read off the alignment: match columns give a match or a delete state,
+ * residues in insert columns give an insert state of the node before them. Residues before the first and after the last
+ * match column are left out
+ * Input:   the aligned sequence, its length, the number of match states, the node of each column and the trace to fill
+ * Output:  nothing
+ * Effect:  set the fields of the trace
+ */
+void trace_sequence(char * sequence, int N, int M, int * column_node, trace_t * trace){
+    int c, k, code, end;
+
+    trace->length = 0;
+    k = 0;      // node of the last match column seen
+    end = 0;    // set once the padding of the row is reached
+    for(c = 0; c < N; c++){
+        if(!end && !sequence[c]) end = 1;
+        code = end ? 0 : residue_code(sequence[c]);
+
+        if(column_node[c]){
+            k = column_node[c];
+            trace->state[trace->length] = code ? STATE_M : STATE_D;
+        } else if(code && k > 0 && k < M)
+            trace->state[trace->length] = STATE_I;
+        else continue;
+
+        trace->node[trace->length]      = k;
+        trace->residue[trace->length]   = code;
+        trace->length++;
+    }
+}
+
+/* Plan7 has no delete-insert or insert-delete transition. As hmmbuild does, such a pair is merged into one match state
+ * emitting the inserted residue at the node of the delete state
+ * Input:   a trace
+ * Output:  nothing
+ * Effect:  modify the trace in place
+ */
+void doctor_trace(trace_t * trace){
+    int from, to;
+
+    for(from = to = 0; from < trace->length; from++, to++){
+        if(from + 1 < trace->length && ((trace->state[from] == STATE_D && trace->state[from + 1] == STATE_I)
+                                     || (trace->state[from] == STATE_I && trace->state[from + 1] == STATE_D))){
+            trace->node[to]     = trace->state[from] == STATE_D ? trace->node[from] : trace->node[from + 1];
+            trace->residue[to]  = trace->residue[from] | trace->residue[from + 1];
+            trace->state[to]    = STATE_M;
+            from++;
+        } else {
+            trace->state[to]    = trace->state[from];
+            trace->node[to]     = trace->node[from];
+            trace->residue[to]  = trace->residue[from];
+        }
+    }
+    trace->length = to;
+}
+
+/* Add the transitions and match emissions of a trace to the counts. The path starts in the begin state (counted as M_0)
+ * and the last state at node M goes to the end state. A degenerate residue is split evenly among the nucleotides it stands for
+ * Input:   the trace, the number of match states, the weight of the sequence and the counts
+ * Output:  nothing
+ * Effect:  add to the counts
+ */
+void count_trace(trace_t * trace, int M, float weight, double * tcount, double * mcount){
+    // Transition from the state in the row to the state in the column
+    static const int transition[3][3] = {
+        { HMM_TMM, HMM_TMI, HMM_TMD },
+        { HMM_TIM, HMM_TII, -1      },
+        { HMM_TDM, -1,      HMM_TDD }
+    };
+    int z, x, bits, from_state, from_node, s;
+
+    from_state = STATE_M;
+    from_node = 0;
+    for(z = 0; z < trace->length; z++){
+        s = transition[(int) from_state][(int) trace->state[z]];
+        if(s >= 0) tcount[from_node * HMM_NUM_TRANSITIONS + s] += weight;
+
+        if(trace->state[z] == STATE_M){
+            for(bits = 0, x = 0; x < HMM_ALPHABET_SIZE; x++) bits += (trace->residue[z] >> x) & 1;
+            for(x = 0; x < HMM_ALPHABET_SIZE; x++)
+                if((trace->residue[z] >> x) & 1) mcount[trace->node[z] * HMM_ALPHABET_SIZE + x] += weight / bits;
+        }
+        from_state = trace->state[z];
+        from_node = trace->node[z];
+    }
+    tcount[M * HMM_NUM_TRANSITIONS + (from_state == STATE_D ? HMM_TDM : HMM_TMM)] += weight;
+}
+
+/* Mean relative entropy to the background, in bits, of the match emissions estimated from the counts scaled by scale
+ * Input:   the match emission counts, the number of match states and the scale of the counts
+ * Output:  the mean relative entropy
+ * Effect:  none
+ */
+double match_relative_entropy(double * mcount, int M, double scale){
+    double total, p, relative_entropy;
+    int k, x;
+
+    relative_entropy = 0;
+    for(k = 1; k <= M; k++){
+        total = 0;
+        for(x = 0; x < HMM_ALPHABET_SIZE; x++) total += scale * mcount[k * HMM_ALPHABET_SIZE + x] + PRIOR_MATCH;
+        for(x = 0; x < HMM_ALPHABET_SIZE; x++){
+            p = (scale * mcount[k * HMM_ALPHABET_SIZE + x] + PRIOR_MATCH) / total;
+            relative_entropy += p * log2(p / BACKGROUND);
+        }
+    }
+    return relative_entropy / M;
+}
+
+/* Entropy weighting: find the effective number of sequences at which the match states reach the target mean relative entropy
+ * The target is raised for short models so that the whole model carries at least TARGET_SIGMA bits
+ * If the counts of all the sequences do not reach the target, the effective number is the number of sequences
+ * Input:   the match emission counts, the number of match states and the number of sequences
+ * Output:  the effective number of sequences
+ * Effect:  none
+ */
+float entropy_weight(double * mcount, int M, int num_seq){
+    double target, low, high, middle;
+    int i; //loop variable
+
+    target = (TARGET_SIGMA - log2(2.0 / ((double) M * (M + 1)))) / M;
+    if(target < TARGET_RELATIVE_ENTROPY) target = TARGET_RELATIVE_ENTROPY;
+    if(match_relative_entropy(mcount, M, 1.0) <= target) return num_seq;
+
+    // The relative entropy grows with the number of sequences, bisect on it
+    low = 0;
+    high = num_seq;
+    for(i = 0; i < MAX_BISECTION; i++){
+        middle = (low + high) / 2;
+        if(match_relative_entropy(mcount, M, middle / num_seq) > target)    high = middle;
+        else                                                                low = middle;
+    }
+    return (low + high) / 2;
+}
+
+/* Mean posterior estimate of the parameters from the scaled counts and the priors, then the special nodes and the consensus
+ * Input:   the allocated hmm, the counts and their scale
+ * Output:  nothing
+ * Effect:  set the parameters and the consensus of the hmm
+ */
+void estimate_parameters(hmm_t * hmm, double * tcount, double * mcount, double scale){
+    static const double prior[HMM_NUM_TRANSITIONS] = { PRIOR_TMM, PRIOR_TMI, PRIOR_TMD, PRIOR_TIM, PRIOR_TII, PRIOR_TDM, PRIOR_TDD };
+    double value[HMM_NUM_TRANSITIONS], total;
+    int M, k, x, s, best;
+
+    M = hmm->M;
+    for(k = 0; k <= M; k++){
+        // Transitions, each state normalized on its own
+        for(s = 0; s < HMM_NUM_TRANSITIONS; s++)
+            value[s] = scale * tcount[k * HMM_NUM_TRANSITIONS + s] + prior[s];
+        if(k == M) value[HMM_TMD] = value[HMM_TDD] = 0;     // no delete state after the last node
+        if(k == 0 || k == M){                               // no delete state 0, the delete state M goes to the end
+            value[HMM_TDM] = 1;
+            value[HMM_TDD] = 0;
+        }
+        total = value[HMM_TMM] + value[HMM_TMI] + value[HMM_TMD];
+        for(s = HMM_TMM; s <= HMM_TMD; s++) hmm_transition(hmm, k, s) = value[s] / total;
+        total = value[HMM_TIM] + value[HMM_TII];
+        for(s = HMM_TIM; s <= HMM_TII; s++) hmm_transition(hmm, k, s) = value[s] / total;
+        total = value[HMM_TDM] + value[HMM_TDD];
+        for(s = HMM_TDM; s <= HMM_TDD; s++) hmm_transition(hmm, k, s) = value[s] / total;
+
+        // Emissions
+        total = 0;
+        for(x = 0; x < HMM_ALPHABET_SIZE; x++) total += scale * mcount[k * HMM_ALPHABET_SIZE + x] + PRIOR_MATCH;
+        for(x = 0; x < HMM_ALPHABET_SIZE; x++){
+            hmm_match(hmm, k, x)    = k == 0 ? (x == 0) : (scale * mcount[k * HMM_ALPHABET_SIZE + x] + PRIOR_MATCH) / total;
+            hmm_insert(hmm, k, x)   = BACKGROUND;
+        }
+    }
+
+    // Consensus, in upper case for strongly conserved states
+    hmm->consensus[0] = ' ';
+    for(k = 1; k <= M; k++){
+        for(best = 0, x = 1; x < HMM_ALPHABET_SIZE; x++)
+            if(hmm_match(hmm, k, x) > hmm_match(hmm, k, best)) best = x;
+        hmm->consensus[k] = hmm_match(hmm, k, best) >= CONSENSUS_THRESHOLD ? "ACGT"[best] : "acgt"[best];
+    }
+    hmm->consensus[M + 1] = 0;
+}
+
+/* Write a probability in the HMMER text format: its negative natural log, or * for 0
+ * Input:   the file and the probability
+ * Output:  nothing
+ * Effect:  write to the file
+ */
+void write_probability(FILE * f, float p){
+    if(p == 0)      fprintf(f, " %8s", "*");
+    else if(p == 1) fprintf(f, " %8.5f", 0.0);
+    else            fprintf(f, " %8.5f", -logf(p));
+}
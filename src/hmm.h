@@ -0,0 +1,77 @@
+// File in HMMDecompositionDecision, created by Thien Le in July 2018
+
+#ifndef HMM_H
+#define HMM_H
+
+#include <stddef.h>
+
+#include "msa.h"
+
+// Nucleotide alphabet (A, C, G, T)
+#define HMM_ALPHABET_SIZE       4
+
+// Transitions out of one node, in the order used by HMMER
+enum hmm_transition {
+    HMM_TMM, HMM_TMI, HMM_TMD,      // from the match state
+    HMM_TIM, HMM_TII,               // from the insert state
+    HMM_TDM, HMM_TDD,               // from the delete state
+    HMM_NUM_TRANSITIONS
+};
+
+// Plan7 profile HMM with M nodes, stored as probabilities
+// Node 0 holds the begin transitions (t[0][TMM, TMI, TMD] go to M_1, I_0, D_1), at node M TMM and TDM go to the end state
+typedef struct hmm {
+    int     M;              // number of match states
+    int     num_seq;        // number of sequences the model was built from
+    float   eff_num_seq;    // effective number of sequences after entropy weighting
+    float*  t;              // (M + 1) x HMM_NUM_TRANSITIONS transition probabilities
+    float*  mat;            // (M + 1) x HMM_ALPHABET_SIZE match emissions, row 0 is unused
+    float*  ins;            // (M + 1) x HMM_ALPHABET_SIZE insert emissions, set to the background
+    int*    map;            // alignment column (starting at 1) of each match state, map[0] is unused
+    char*   consensus;      // consensus residue of each match state, null terminated, consensus[0] is unused
+} hmm_t;
+
+// States of a trace through the model
+#define STATE_M                 0
+#define STATE_I                 1
+#define STATE_D                 2
+
+// Path of one sequence through the model
+typedef struct trace {
+    int     length;     // number of states in the path
+    char*   state;      // STATE_M, STATE_I or STATE_D
+    int*    node;       // node of each state
+    int*    residue;    // residue code emitted by each state, 0 for a delete state
+} trace_t;
+
+// Accessors
+#define hmm_transition(h, k, s) ((h)->t[(size_t) (k) * HMM_NUM_TRANSITIONS + (s)])
+#define hmm_match(h, k, x)      ((h)->mat[(size_t) (k) * HMM_ALPHABET_SIZE + (x)])
+#define hmm_insert(h, k, x)     ((h)->ins[(size_t) (k) * HMM_ALPHABET_SIZE + (x)])
+
+// Constructor & destructor
+extern int init_hmm(hmm_t * hmm);
+extern void destroy_hmm(hmm_t * hmm);
+
+// Build a model from an alignment (or a view of one)
+extern int build_hmm(hmm_t * hmm, msa_t * msa, float symfrac);
+
+// IO functions
+extern int write_hmm(hmm_t * hmm, char * filename);
+
+// Copy of the model in one buffer and back, used to cache models
+extern int pack_hmm(hmm_t * hmm, char ** buffer, size_t * length);
+extern int unpack_hmm(hmm_t * hmm, char * buffer, size_t length);
+
+// Set of nucleotides a character of an alignment stands for, one bit per nucleotide
+extern int residue_code(char c);
+
+// Path of an aligned sequence read off its columns, column_node holds the node of each match column and 0 elsewhere
+// The trace needs room for N states. doctor_trace removes the delete-insert pairs Plan7 cannot follow
+extern void trace_sequence(char * sequence, int N, int M, int * column_node, trace_t * trace);
+extern void doctor_trace(trace_t * trace);
+
+// Number of free parameters, used by the model selection criteria
+extern int hmm_num_parameters(hmm_t * hmm);
+
+#endif
@@ -0,0 +1,173 @@
+// File in HMMDecompositionDecision, created by Thien Le in July 2018
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
+
+#include "kernel.h"
+
+// Private function templates
+int     supported_always        (void);
+
+#ifdef __x86_64__
+int     supported_sse41         (void);
+int     supported_avx2          (void);
+int     supported_avx512        (void);
+void    viterbi_batch_sse2      (profile_t * profile, char * dsq, int stride, int * L, float * dp, float * score);
+void    viterbi_batch_sse41     (profile_t * profile, char * dsq, int stride, int * L, float * dp, float * score);
+void    viterbi_batch_avx2      (profile_t * profile, char * dsq, int stride, int * L, float * dp, float * score);
+void    viterbi_batch_avx512    (profile_t * profile, char * dsq, int stride, int * L, float * dp, float * score);
+#endif
+
+// Fields                   name        supported           lanes   batch                   striped
+kernel_t kernels[] = {
+                        {   "scalar",   supported_always,   1,      NULL,                   0 },
+#ifdef __x86_64__
+                        {   "sse2",     supported_always,   4,      viterbi_batch_sse2,     1 },
+                        {   "sse4.1",   supported_sse41,    4,      viterbi_batch_sse41,    1 },
+                        {   "avx2",     supported_avx2,     8,      viterbi_batch_avx2,     1 },
+                        {   "avx512",   supported_avx512,   16,     viterbi_batch_avx512,   1 },
+#endif
+};
+int num_kernels = sizeof(kernels) / sizeof(kernel_t);
+
+/* Fastest kernel the cpu supports, the instruction sets are read with cpuid
+ * Input:   none
+ * Output:  the kernel
+ * Effect:  none
+ */
+kernel_t * best_kernel(void){
+    int i;
+
+    for(i = num_kernels - 1; i > 0; i--)
+        if(kernels[i].supported()) break;
+    return &kernels[i];
+}
+
+/* Kernel of a given name
+ * Input:   the name
+ * Output:  the kernel, NULL if no kernel has this name
+ * Effect:  none
+ */
+kernel_t * find_kernel(char * name){
+    int i;
+
+    for(i = 0; i < num_kernels; i++)
+        if(strcmp(kernels[i].name, name) == 0) return &kernels[i];
+    return NULL;
+}
+
+
+//INTERNAL FUNCTIONS IMPLEMENTATIONS
+
+// SSE2 is part of x86-64 and the scalar kernel runs anywhere
+int supported_always(void)      { return 1; }
+
+#ifdef __x86_64__
+int supported_sse41(void)       { return __builtin_cpu_supports("sse4.1"); }
+int supported_avx2(void)        { return __builtin_cpu_supports("avx2"); }
+int supported_avx512(void)      { return __builtin_cpu_supports("avx512f"); }
+
+// SSE2, the baseline of x86-64
+#define BATCH_NAME              viterbi_batch_sse2
+#define LANES                   4
+#define VEC                     __m128
+#define MASK                    __m128
+#define RESIDUES                int *
+#define VSET1(a)                _mm_set1_ps(a)
+#define VZERO()                 _mm_setzero_ps()
+#define VLOADU(p)               _mm_loadu_ps(p)
+#define VSTOREU(p, v)           _mm_storeu_ps(p, v)
+#define VADD(a, b)              _mm_add_ps(a, b)
+#define VMAX(a, b)              _mm_max_ps(a, b)
+#define VNEGATIVE(v)            _mm_cmplt_ps(v, _mm_setzero_ps())
+#define VSELECT(m, a, b)        _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b))
+#define LOAD_RESIDUES(x)        (x)
+#define EMISSIONS(e, r)         _mm_set_ps(e[r[3]], e[r[2]], e[r[1]], e[r[0]])
+#include "viterbi_batch.h"
+#undef BATCH_NAME
+#undef VSELECT
+
+// SSE4.1 selects the finished lanes with a blend
+#pragma GCC push_options
+#pragma GCC target("sse4.1")
+#define BATCH_NAME              viterbi_batch_sse41
+#define VSELECT(m, a, b)        _mm_blendv_ps(b, a, m)
+#include "viterbi_batch.h"
+#pragma GCC pop_options
+#undef BATCH_NAME
+#undef LANES
+#undef VEC
+#undef MASK
+#undef RESIDUES
+#undef VSET1
+#undef VZERO
+#undef VLOADU
+#undef VSTOREU
+#undef VADD
+#undef VMAX
+#undef VNEGATIVE
+#undef VSELECT
+#undef LOAD_RESIDUES
+#undef EMISSIONS
+
+// AVX2, 8 sequences at once and the emission scores gathered in one instruction
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#define BATCH_NAME              viterbi_batch_avx2
+#define LANES                   8
+#define VEC                     __m256
+#define MASK                    __m256
+#define RESIDUES                __m256i
+#define VSET1(a)                _mm256_set1_ps(a)
+#define VZERO()                 _mm256_setzero_ps()
+#define VLOADU(p)               _mm256_loadu_ps(p)
+#define VSTOREU(p, v)           _mm256_storeu_ps(p, v)
+#define VADD(a, b)              _mm256_add_ps(a, b)
+#define VMAX(a, b)              _mm256_max_ps(a, b)
+#define VNEGATIVE(v)            _mm256_cmp_ps(v, _mm256_setzero_ps(), _CMP_LT_OQ)
+#define VSELECT(m, a, b)        _mm256_blendv_ps(b, a, m)
+#define LOAD_RESIDUES(x)        _mm256_loadu_si256((__m256i *) (x))
+#define EMISSIONS(e, r)         _mm256_i32gather_ps(e, r, sizeof(float))
+#include "viterbi_batch.h"
+#pragma GCC pop_options
+#undef BATCH_NAME
+#undef LANES
+#undef VEC
+#undef MASK
+#undef RESIDUES
+#undef VSET1
+#undef VZERO
+#undef VLOADU
+#undef VSTOREU
+#undef VADD
+#undef VMAX
+#undef VNEGATIVE
+#undef VSELECT
+#undef LOAD_RESIDUES
+#undef EMISSIONS
+
+// AVX-512, 16 sequences at once with mask registers
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+#define BATCH_NAME              viterbi_batch_avx512
+#define LANES                   16
+#define VEC                     __m512
+#define MASK                    __mmask16
+#define RESIDUES                __m512i
+#define VSET1(a)                _mm512_set1_ps(a)
+#define VZERO()                 _mm512_setzero_ps()
+#define VLOADU(p)               _mm512_loadu_ps(p)
+#define VSTOREU(p, v)           _mm512_storeu_ps(p, v)
+#define VADD(a, b)              _mm512_add_ps(a, b)
+#define VMAX(a, b)              _mm512_max_ps(a, b)
+#define VNEGATIVE(v)            _mm512_cmp_ps_mask(v, _mm512_setzero_ps(), _CMP_LT_OQ)
+#define VSELECT(m, a, b)        _mm512_mask_blend_ps(m, b, a)
+#define LOAD_RESIDUES(x)        _mm512_loadu_si512(x)
+#define EMISSIONS(e, r)         _mm512_i32gather_ps(r, e, sizeof(float))
+#include "viterbi_batch.h"
+#pragma GCC pop_options
+#endif
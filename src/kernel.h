@@ -0,0 +1,31 @@
+// File in HMMDecompositionDecision, created by Thien Le in July 2018
+
+#ifndef KERNEL_H
+#define KERNEL_H
+
+#include "viterbi.h"
+
+// Largest number of sequences a kernel scores at once (AVX-512)
+#define KERNEL_MAX_LANES        16
+
+// Viterbi scores in nats of lanes sequences at once, one per vector lane, see viterbi_batch.h
+typedef void (*batch_kernel_t)(profile_t * profile, char * dsq, int stride, int * L, float * dp, float * score);
+
+// Implementation of the Viterbi kernels for one instruction set
+typedef struct kernel {
+    char *          name;           // name taken by --kernel
+    int             (*supported)(void); // whether the cpu runs the kernel, from cpuid
+    int             lanes;          // number of sequences scored at once, 1 if there is no inter-sequence kernel
+    batch_kernel_t  batch;          // inter-sequence kernel, NULL if there is none
+    int             striped;        // whether single sequences are scored with the striped SSE2 kernel
+} kernel_t;
+
+// Kernels compiled in, from the slowest to the fastest
+extern kernel_t kernels[];
+extern int num_kernels;
+
+// Fastest kernel the cpu supports, and the kernel called name (NULL if there is none)
+extern kernel_t * best_kernel(void);
+extern kernel_t * find_kernel(char * name);
+
+#endif
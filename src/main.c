@@ -4,30 +4,29 @@
 #include <stdlib.h>
 #include <string.h>
 
-#include "msa.h"
-#include "tree.h"
 #include "utilities.h"
 #include "options.h"
-#include "tools.h"
-#include "stat.h"
+#include "viterbi.h"
+#include "pipeline.h"
+#include "batch.h"
+#include "server.h"
+#include "report.h"
 
 #define DEBUG
 
 // Helper function that determines how many structures are completely allocated (as opposed to aborted by malloc failure) and free the allocation
-void clean_up(int allocated, msa_t * msa, msa_t * msa1, msa_t * msa2, option_t * options, float * L, float * L1, float * L2){
+void clean_up(int allocated, option_t * options, report_t * report, cache_t * cache, batch_t * batch){
     switch(allocated){
-        case 7: 
-            free(L2);
-        case 6:
-            free(L1);
-        case 5:
-            free(L);
         case 4:
-            destroy_msa(msa2);
+            destroy_batch(batch);
         case 3:
-            destroy_msa(msa1);
+            destroy_cache(cache);
         case 2:
-            destroy_msa(msa);
+            // The report and the trace are written however the run ends, failed stages included
+            if(active_report && options->profile_index != NULL_OPTION) write_report(report, options->profile_name);
+            if(active_report && options->trace_index != NULL_OPTION) write_trace(report, options->trace_name);
+            active_report = NULL;
+            destroy_report(report);
         case 1:
             destroy_options(options);
         default:
@@ -35,104 +34,124 @@ void clean_up(int allocated, msa_t * msa, msa_t * msa1, msa_t * msa2, option_t *
     }
 }
 
-#define ALLOCATED_INFO allocated, &msa, &msa1, &msa2, &options, L, L1, L2
+#define ALLOCATED_INFO allocated, &options, &report, &cache, &batch
 
 // Main function
 int main(int argc, char ** argv){
     option_t options;           //commnd line options
-    msa_t msa, msa1, msa2;      // msa struct for the single HMM and 2 msa structs for the double HMM
     int allocated;              // heap allocation counter (to prevent mem leak)
-    int left_root, right_root;  // endpoints of centroid decomposition
-    float *L, *L1, *L2;          // array to bit score for the single HMM and 2 HMMs for the double HMM 
-    int best_model_bic, best_model_aic;
-
-    L = NULL;
-    L1 = NULL;
-    L2 = NULL;
+    family_t family;            // the alignment, or the settings shared by the alignments of a batch
+    batch_t batch;              // alignments of --batch
+    server_t server;            // daemon of --serve
+    cache_t cache;              // artifacts of --cache
+    report_t report;            // time and resources of every stage for --profile and --trace
+    int status;
+    int keep;                   // whether the intermediate files are written to the working directory
+    int num_failed;
+    int i; //loop variable
 
     allocated =  0;
+    cache.dir = NULL;
 
     // Read options
     if(init_options(&options)                   != SUCCESS)         PRINT_AND_EXIT("init option failed in main",                GENERAL_ERROR, ALLOCATED_INFO);
     if(read_cmd_arg(argc, argv, &options)       != SUCCESS)         PRINT_AND_EXIT("read command line args failed in main",     GENERAL_ERROR, ALLOCATED_INFO);
     allocated = 1;
-    if(options.input_index                      == NULL_OPTION)     PRINT_AND_EXIT("must have valid input name",                GENERAL_ERROR, ALLOCATED_INFO);
-    else{
-        single_model_build_option.input_name            = options.input_name;
-        fasttree_options.input_name                     = options.input_name;
-        single_model_search_option.input_sequences_name = options.input_name;
-    }
 
-    // Allocate MSA and HMM structs on the stack
-    printf("Parsing input options.\n");
-    if(parse_input(&msa, options.input_name)    != SUCCESS)         PRINT_AND_EXIT("init msa failed in main",                   GENERAL_ERROR, ALLOCATED_INFO);
+    // Every stage and child process is measured from here on
+    if(init_report(&report)                     != SUCCESS)         PRINT_AND_EXIT("init report failed in main",                GENERAL_ERROR, ALLOCATED_INFO);
+    if(options.profile_index != NULL_OPTION || options.trace_index != NULL_OPTION) active_report = &report;
     allocated = 2;
 
-    printf("Building single model HMM..\n");
-    // Call HMMbuild job for first model
-    if(hmmbuild_job(&single_model_build_option) != SUCCESS)         PRINT_AND_EXIT("first model HMMbuild failed in main",       GENERAL_ERROR, ALLOCATED_INFO);
-
-    printf("Building tree..\n");
-    // Call FastTree to build ML tree for the second model
-    if(fasttree_job(&fasttree_options)          != SUCCESS)         PRINT_AND_EXIT("fast tree failed in main",                  GENERAL_ERROR, ALLOCATED_INFO);
+    family = (family_t) { options.input_name };
+    family.symfrac = DEFAULT_SYMFRAC;
+    if(options.symfrac_index                    != NULL_OPTION){
+        family.symfrac = atof(options.symfrac);
+        if(family.symfrac < 0 || family.symfrac > 1)
+                                                                    PRINT_AND_EXIT("symfrac must be between 0 and 1",           GENERAL_ERROR, ALLOCATED_INFO);
+    }
+    family.band = NULL_OPTION;
+    if(options.score_index                      != NULL_OPTION){
+        if(strcmp(options.score_mode, "path") == 0)         family.band = 0;
+        else if(strcmp(options.score_mode, "band") == 0)    family.band = options.band;
+        else if(strcmp(options.score_mode, "viterbi") != 0) PRINT_AND_EXIT("score must be viterbi, path or band",       GENERAL_ERROR, ALLOCATED_INFO);
+    }
+    keep = options.keep_index != NULL_OPTION || options.output_index != NULL_OPTION;
+    if(keep && set_output_names(&options)       != SUCCESS)         PRINT_AND_EXIT("set output names failed in main",           GENERAL_ERROR, ALLOCATED_INFO);
+    if(keep) printf("Intermediate files are written to %s.*\n", options.output_prefix);
+    // A run can only be resumed from the intermediate files of an earlier run with the same prefix
+    family.resume = options.resume_index != NULL_OPTION;
+    if(family.resume && options.output_index    == NULL_OPTION)     PRINT_AND_EXIT("--resume needs the prefix of the run with -o",  GENERAL_ERROR, ALLOCATED_INFO);
+    family.check = options.kernel_index != NULL_OPTION && strcmp(options.kernel, "check") == 0;
+    if(options.kernel_index != NULL_OPTION && !family.check && set_kernel(options.kernel) != SUCCESS)
+                                                                    PRINT_AND_EXIT("kernel must be scalar, sse2, sse4.1, avx2, avx512 or check, and run on this cpu",  GENERAL_ERROR, ALLOCATED_INFO);
+    // The load generator only needs the alignment it sends
+    if(options.client_index                     != NULL_OPTION){
+        if(options.input_index                  == NULL_OPTION)     PRINT_AND_EXIT("must have valid input name",                GENERAL_ERROR, ALLOCATED_INFO);
+        status = run_client(options.client_name, options.input_name, options.num_requests, options.num_jobs);
+        PRINT_AND_EXIT("Finished, cleaning up", status, ALLOCATED_INFO);
+    }
+    if(options.input_index == NULL_OPTION && options.batch_index == NULL_OPTION && options.serve_index == NULL_OPTION)
+                                                                    PRINT_AND_EXIT("must have valid input name",                GENERAL_ERROR, ALLOCATED_INFO);
+
+    // Trees, hmms and scores are looked up in the cache before they are computed
+    if(options.cache_index                      != NULL_OPTION){
+        if(init_cache(&cache, options.cache_name, options.cache_size << 20)
+                                                != SUCCESS)         PRINT_AND_EXIT("init cache failed in main",                 GENERAL_ERROR, ALLOCATED_INFO);
+        family.cache = &cache;
+    }
+    allocated = 3;
 
+    printf("Parsing input options.\n");
+    printf("Scoring with the %s kernels.\n", kernel_name());
+
+    // A batch runs one alignment per thread, each alone, on as many threads as external jobs
+    if(options.batch_index                      != NULL_OPTION){
+        if(init_batch(&batch)                   != SUCCESS)         PRINT_AND_EXIT("init batch failed in main",                 GENERAL_ERROR, ALLOCATED_INFO);
+        allocated = 4;
+        if(read_batch(&batch, options.batch_name)
+                                                != SUCCESS)         PRINT_AND_EXIT("read batch failed in main",                 GENERAL_ERROR, ALLOCATED_INFO);
+        family.num_threads = family.num_jobs = 1;
+        printf("Running %d alignments on %d threads.\n", batch.num_families, options.num_jobs);
+        if(run_batch(&batch, &family, keep ? options.output_prefix : NULL, options.num_jobs)
+                                                != SUCCESS)         PRINT_AND_EXIT("run batch failed in main",                  GENERAL_ERROR, ALLOCATED_INFO);
+        if(write_batch(&batch, options.results_name ? options.results_name : DEFAULT_RESULTS_NAME)
+                                                != SUCCESS)         PRINT_AND_EXIT("write batch failed in main",                GENERAL_ERROR, ALLOCATED_INFO);
+        for(num_failed = i = 0; i < batch.num_families; i++) num_failed += batch.status[i] != SUCCESS;
+        printf("%d of %d alignments failed, results are in %s\n", num_failed, batch.num_families,
+               options.results_name ? options.results_name : DEFAULT_RESULTS_NAME);
+        if(family.cache) print_cache(family.cache);
+        PRINT_AND_EXIT("Finished, cleaning up", num_failed ? GENERAL_ERROR : SUCCESS, ALLOCATED_INFO);
+    }
 
-    // Parse result of FastTree
-    if(read_newick(fasttree_options.output_name)!= SUCCESS)         PRINT_AND_EXIT("read newick failed in main",                GENERAL_ERROR, ALLOCATED_INFO);
+    // The daemon answers requests with as many threads as external jobs, each request runs alone on the worker that
+    // accepted it as a batch alignment does, so no thread is started and no DP row allocated per request
+    if(options.serve_index                      != NULL_OPTION){
+        family.num_threads = family.num_jobs = 1;
+        if(init_server(&server, options.serve_name, &family, options.num_jobs)
+                                                != SUCCESS)         PRINT_AND_EXIT("init server failed in main",                GENERAL_ERROR, ALLOCATED_INFO);
+        printf("Listening on %s with %d threads.\n", options.serve_name, options.num_jobs);
+        fflush(stdout);
+        status = run_server(&server);
+        printf("Answered %d requests.\n", server.served);
+        if(family.cache) print_cache(family.cache);
+        destroy_server(&server);
+        if(status                               != SUCCESS)         PRINT_AND_EXIT("run server failed in main",                 GENERAL_ERROR, ALLOCATED_INFO);
+        PRINT_AND_EXIT("Finished, cleaning up", SUCCESS, ALLOCATED_INFO);
+    }
 
-    // Do centroid decomposition on the second model
-    printf("Doing centroid decomposition..\n");
-    if(centroid_decomposition(&left_root, &right_root)
-                                                != SUCCESS)         PRINT_AND_EXIT("centroid decomposition failed in main",     GENERAL_ERROR, ALLOCATED_INFO);
-    
-    if(make_smaller_msa(&msa, &msa1)            != SUCCESS)         PRINT_AND_EXIT("make small msa 1 failed in main",           GENERAL_ERROR, ALLOCATED_INFO);
-    allocated = 3;
-    if(make_smaller_msa(&msa, &msa2)            != SUCCESS)         PRINT_AND_EXIT("make small msa 2 failed in main",           GENERAL_ERROR, ALLOCATED_INFO);
-    allocated = 4;
-    if(retrieve_msa_from_root(left_root, right_root, &msa1, &msa2, &msa)
-                                                != SUCCESS)         PRINT_AND_EXIT("retrieve_msa_from_root failed in main",     GENERAL_ERROR, ALLOCATED_INFO);
-
-    // Write MSA to a file in FASTA format
-    if(write_msa(&msa1, DEFAULT_DOUBLE_FIRST_MSA_NAME)
-                                                != SUCCESS)         PRINT_AND_EXIT("write msa 1 failed in main",                GENERAL_ERROR, ALLOCATED_INFO);
-    if(write_msa(&msa2, DEFAULT_DOUBLE_SECOND_MSA_NAME)
-                                                != SUCCESS)         PRINT_AND_EXIT("write msa 2 failed in main",                GENERAL_ERROR, ALLOCATED_INFO);
-
-    // Call HMMbuild for the second model
-    printf("Building second model..\n");
-    if(hmmbuild_job(&double_model_first_build_option) 
-                                                != SUCCESS)         PRINT_AND_EXIT("double model 1st hmmbuild failed in main",  GENERAL_ERROR, ALLOCATED_INFO);
-    if(hmmbuild_job(&double_model_second_build_option)
-                                                != SUCCESS)         PRINT_AND_EXIT("double model 2nd hmmbuild failed in main",  GENERAL_ERROR, ALLOCATED_INFO);
-
-    // Compute Viterbi for first model
-    printf("Computing likelihood for both models..\n");
-    if(hmmsearch_job(&single_model_search_option) 
-                                                != SUCCESS)         PRINT_AND_EXIT("single model hmmsearch failed in main",     GENERAL_ERROR, ALLOCATED_INFO);
-
-    if(compute_likelihood(DEFAULT_HMMSEARCH_OUT_SINGLE, msa.num_seq, &L)
-                                                != SUCCESS)         PRINT_AND_EXIT("compute likelihood single model failed",    GENERAL_ERROR, ALLOCATED_INFO);
-
-    allocated = 5;
-    // Compute Viterbi for second model
-    if(hmmsearch_job(&double_model_fist_search_option) 
-                                                != SUCCESS)         PRINT_AND_EXIT("double model first hmmsearch failed in main",GENERAL_ERROR, ALLOCATED_INFO);
-    if(hmmsearch_job(&double_model_second_search_option) 
-                                                != SUCCESS)         PRINT_AND_EXIT("double model second hmmsearch failed in main",GENERAL_ERROR, ALLOCATED_INFO);
-    if(compute_likelihood(DEFAULT_HMMSEARCH_OUT_FIRST_DOUBLE, msa1.num_seq, &L1)
-                                                != SUCCESS)         PRINT_AND_EXIT("compute likelihood failed for first hmm, double model", GENERAL_ERROR, ALLOCATED_INFO);
-    allocated = 6;
-    if(compute_likelihood(DEFAULT_HMMSEARCH_OUT_SECOND_DOUBLE, msa2.num_seq, &L2)
-                                                != SUCCESS)         PRINT_AND_EXIT("compute likelihood failed for second hmm, double model", GENERAL_ERROR, ALLOCATED_INFO);
-    allocated = 7;
+    family.prefix = keep ? options.output_prefix : NULL;
+    family.num_threads = options.num_threads;
+    family.num_jobs = options.num_jobs;
+    if(run_family(&family)                      != SUCCESS)         PRINT_AND_EXIT("pipeline failed in main",                   GENERAL_ERROR, ALLOCATED_INFO);
 
     // Perform statistical test, currently, only BIC is used but can easily incorporate other tests
-    
-    if(bic(&msa, &msa1, &msa2, L, L1, L2, DEFAULT_HMMBUILD_OUT_SINGLE_NAME, &best_model_bic)
-                                                != SUCCESS)         PRINT_AND_EXIT("problem with computing bic in main", GENERAL_ERROR, ALLOCATED_INFO);
-    printf("The best model according to BIC is %d\n", best_model_bic);
-    if(aic(&msa, &msa1, &msa2, L, L1, L2, DEFAULT_HMMBUILD_OUT_SINGLE_NAME, &best_model_aic)
-                                                != SUCCESS)         PRINT_AND_EXIT("problem with computing aic in main", GENERAL_ERROR, ALLOCATED_INFO);
-    printf("The best model according to AIC is %d\n", best_model_aic);
+    printf("Delta BIC (2 v 1) is %f, log odd of double model is %f, log odd of single model is %f\n",
+           family.bic.delta, family.bic.double_log_odd, family.bic.single_log_odd);
+    printf("The best model according to BIC is %d\n", family.bic.best_model);
+    printf("Delta AIC (2 v 1) is %f, log odd of double model is %f, log odd of single model is %f\n",
+           family.aic.delta, family.aic.double_log_odd, family.aic.single_log_odd);
+    printf("The best model according to AIC is %d\n", family.aic.best_model);
+    if(family.cache) print_cache(family.cache);
     PRINT_AND_EXIT("Finished, cleaning up", SUCCESS, ALLOCATED_INFO);
-}
\ No newline at end of file
+}
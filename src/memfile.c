@@ -0,0 +1,29 @@
+// File in HMMDecompositionDecision, created by Thien Le in July 2018
+
+#define _GNU_SOURCE     // memfd_create and O_TMPFILE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "memfile.h"
+#include "utilities.h"
+
+/* Create an anonymous file in memory. It is close-on-exec so a child running another command never inherits it, but its
+ * path names this process (not /proc/self) so any child can still open it, before exec for a redirection or after
+ * Input:   the name shown in /proc for debugging and room for MEMFILE_PATH_SIZE characters
+ * Output:  the file descriptor, ERROR otherwise
+ * Effect:  create a file, set path
+ */
+int open_memfile(char * name, char * path){
+    int fd;
+
+    fd = memfd_create(name, MFD_CLOEXEC);
+    if(fd < 0) fd = open(P_tmpdir, O_TMPFILE | O_RDWR | O_CLOEXEC, 0600);
+    if(fd < 0)      PRINT_AND_RETURN("memfd_create and O_TMPFILE failed in open_memfile",  OPEN_ERROR);
+
+    snprintf(path, MEMFILE_PATH_SIZE, "/proc/%d/fd/%d", (int) getpid(), fd);
+    return fd;
+}
@@ -0,0 +1,16 @@
+// File in HMMDecompositionDecision, created by Thien Le in July 2018
+
+#ifndef MEMFILE_H
+#define MEMFILE_H
+
+#include <stddef.h>
+
+// Room for the /proc/<pid>/fd path of a memory file
+#define MEMFILE_PATH_SIZE       64
+
+// Anonymous file held in memory (memfd_create, or an unlinked O_TMPFILE file where there is none), reachable by this
+// process and the children it starts through the /proc/<pid>/fd path written to path. Returns the descriptor, to be closed
+// once the file is no longer needed
+extern int open_memfile(char * name, char * path);
+
+#endif
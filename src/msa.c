@@ -3,171 +3,215 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pthread.h>
 
 #include "msa.h"
 #include "utilities.h"
 #include "tree.h"
+#include "report.h"
+
+// Smallest part of the input given to one parsing thread
+#define MIN_CHUNK_SIZE          (1 << 20)
+
+// A part of the mapped FASTA file cut on record boundaries, parsed by one thread
+typedef struct input_chunk {
+    char*   data;       // start of the chunk in the mapped file
+    size_t  size;       // length of the chunk
+    int     num_seq;    // number of records starting in the chunk
+    int     N;          // length of the first record of the chunk
+    size_t  names_size; // size of the names of the records of the chunk
+    int     first_row;  // row of the first record of the chunk in the msa
+    size_t  first_name; // offset of the first name of the chunk in the name arena
+    msa_t*  msa;        // msa being filled
+    int     status;     // return value of the pass run on the chunk
+} input_chunk_t;
 
 // Private function templates
-int     setup_name              (char ** name_holder, char* name);
-int     setup_sequence          (char ** sequence_holder, char* sequence);
-char*   find_sequence_by_name   (msa_t * msa, char * name);
-int     add_to_msa_from_msa     (msa_t * original, msa_t * new, char * name);
-void    dfs_msa                 (int cur_node, int par_node, int centroid, msa_t * all_msa, msa_t * small_msa);
+char*   header_name             (char * line, size_t length, size_t * name_length);
+size_t  copy_residues           (char * line, size_t length, char * out, size_t room);
+size_t  next_record             (char * data, size_t size, size_t pos);
+int     split_input             (char * data, size_t size, int num_threads, input_chunk_t ** chunks);
+void    run_chunks              (input_chunk_t * chunks, int num_chunks, void * (*pass)(void *));
+void*   count_chunk             (void * chunk);
+void*   fill_chunk              (void * chunk);
+int     count_input             (char * data, size_t size, int * num_seq, int * N, size_t * names_size);
+int     fill_input              (char * data, size_t size, msa_t * msa, int first_row, size_t first_name);
+int     finish_sequence         (msa_t * msa, int row, size_t length);
+unsigned int hash_name          (char * name);
+int     build_name_index        (msa_t * msa);
+int     find_row_by_name        (msa_t * msa, char * name);
+int     add_to_msa_from_msa     (msa_t * original, msa_t * new, int row);
 
 /* Initialize fields in the MSA to predetermined values
  * Input:   msa         pointer to the MSA srtuct
  *          N           length of each sequence
  *          num_seq     number of sequences in the MSA
- *          msa_core    array of sequences 
- *          msa_name    array of name for each sequence
+ *          residues    num_seq x msa_stride(N) residue matrix aligned to MSA_ALIGNMENT
+ *          name_offset offset of the name of each sequence in names
+ *          names       name arena
  * Output:  0 on success, ERROR otherwise
  * Effect   set fields in the input msa
  */
-int init_msa(msa_t* msa, int N, int num_seq, char** msa_core, char** msa_name){
+int init_msa(msa_t* msa, int N, int num_seq, char* residues, int* name_offset, char* names){
     // Safety check
-    if(!msa)        PRINT_AND_RETURN("msa is NULL from init_msa",       GENERAL_ERROR);
-    if(!msa_core)   PRINT_AND_RETURN("msa_core is NULL from init_msa",  GENERAL_ERROR);
-    if(!msa_name)   PRINT_AND_RETURN("msa_name is NULL from init_msa",  GENERAL_ERROR);
+    if(!msa)        PRINT_AND_RETURN("msa is NULL from init_msa",           GENERAL_ERROR);
+    if(!residues)   PRINT_AND_RETURN("residues is NULL from init_msa",      GENERAL_ERROR);
+    if(!name_offset)PRINT_AND_RETURN("name_offset is NULL from init_msa",   GENERAL_ERROR);
+    if(!names)      PRINT_AND_RETURN("names is NULL from init_msa",         GENERAL_ERROR);
 
     // Set the fields
     msa->N = N;
     msa->num_seq = num_seq;
-    msa->msa = msa_core;
-    msa->name = msa_name;
+    msa->stride = msa_stride(N);
+    msa->residues = residues;
+    msa->name_offset = name_offset;
+    msa->names = names;
+    msa->name_index = NULL;
+    msa->index_size = 0;
+    msa->parent = NULL;
+    msa->rows = NULL;
     return 0;
 }
 
-/* A destructor for the struct msa that loops through all mallocated fields and set other fields to 0
+/* A destructor for the struct msa that frees all mallocated fields and set other fields to 0
+ * The residues and the names are each a single block so this is a constant number of frees
+ * For a view only the row indices are freed, the parent is left untouched
  * This does not deallocate the struct itself if the struct was from heap memory
  * Input:       msa struct
  * Output:      nothing
  * Effect:      freeing mallocated blocks
  */
 void destroy_msa(msa_t * msa){
-    int i; //loop variable
-
     // Safe cheking: if the structure was never allocated then does nothing
     if(!msa) return;
 
-    // Free the names and the sequences containing in the msa
-    for (i = 0; i < msa->num_seq; i++){
-        free(msa->msa[i]);
-        free(msa->name[i]);
-    }
-
     // Set other fields to 0
-    free(msa->msa);
-    free(msa->name);
-    msa->N = msa->num_seq = 0;
+    free(msa->residues);
+    free(msa->name_offset);
+    free(msa->names);
+    free(msa->name_index);
+    free(msa->rows);
+    msa->residues = msa->names = NULL;
+    msa->name_offset = msa->name_index = msa->rows = NULL;
+    msa->parent = NULL;
+    msa->N = msa->num_seq = msa->stride = msa->index_size = 0;
 }
 
 
-/* Parse FASTA file into msa_t struct. This function assumes a maximum length of a sequence and number of sequences currently
- * Input:   pointer to the msa and name of the FASTA file
+/* Parse FASTA file into msa_t struct. The file is mapped into memory and cut into chunks on record boundaries,
+ * one per thread. A first pass counts the records and names of every chunk in parallel, prefix sums of the counts
+ * give the first row and name offset of each chunk, and a second pass copies the chunks in parallel into storage
+ * sized exactly, so the whole alignment takes one residue matrix, one name arena and one offset array
+ * Input:   pointer to the msa, name of the FASTA file and number of threads to use
  * Output:  0 on sucess, GENERAL_ERROR otherwise
  * Effect:  may print onto outstream if error occurs, set fields in the msa struct, 
- *          open instream, assuming filename is in the same directory as the binary file
- *          calls malloc
+ *          map the file, assuming filename is in the same directory as the binary file
+ *          calls malloc, starts up to num_threads - 1 threads
  */
-int parse_input(msa_t * msa_ptr, char * filename){
-    // Placeholder for contents of the msa
-    char** msa_core;
-    char** msa_name;
-
-    int i; //loop variable
-
+int parse_input(msa_t * msa_ptr, char * filename, int num_threads){
     // Input FASTA file
-    FILE * f;
+    int fd;
+    struct stat file_stat;
+    char * data;
+    size_t size;
+
+    // Chunks and sizes found by the first pass
+    input_chunk_t * chunks;
+    int num_chunks;
+    int num_seq;
+    int N;
+    size_t names_size;
+    int i; //loop variable
+    report_span_t phase;        // both passes are phases of the trace
 
-    // File reader variables
-    int sequence_counter;
-    char line[MAX_SEQUENCE_LENGTH];
-    char seq[MAX_SEQUENCE_LENGTH];
+    // Storage 
+    char * residues;
+    int * name_offset;
+    char * names;
 
     // Safe checking
     if(!msa_ptr)    PRINT_AND_RETURN("msa_ptr is NULL in parse input",          GENERAL_ERROR);
     if(!filename)   PRINT_AND_RETURN("filename is NULL in parse input",         GENERAL_ERROR);
 
-    // Allocate space
-    msa_core = malloc(MAX_NUM_SEQUENCE * sizeof(char*));
-    msa_name = malloc(MAX_NUM_SEQUENCE * sizeof(char*)); 
-    if(!msa_core)   PRINT_AND_RETURN("malloc for msa_core failed in parse_input",   MALLOC_ERROR);
-    if(!msa_name){
-        free(msa_core);
-        PRINT_AND_RETURN("malloc for msa_name failed in parse_input",   MALLOC_ERROR);
+    // Map the whole file
+    fd = open(filename, O_RDONLY);
+    if(fd < 0)      PRINT_AND_RETURN("fail to open input file",  OPEN_ERROR);    
+    if(fstat(fd, &file_stat) != 0 || file_stat.st_size == 0){
+        close(fd);
+        PRINT_AND_RETURN("input file contains no sequence",   GENERAL_ERROR);
     }
-
-    // Clear strings    
-    sequence_counter = 0;
-    strclr(seq);
-    strclr(line);
-
-    // Redirecting stdin
-    f = freopen(filename, "r", stdin);
-    if(!f) PRINT_AND_RETURN("fail to open input file",  OPEN_ERROR);    
-
-    // Ignoring comments
-    while(1){
-        if(scanf("%s", line) < 0) PRINT_AND_RETURN("input file contains no sequence",   GENERAL_ERROR);
-        if(str_start_with(line, '>')) break; 
+    size = file_stat.st_size;
+    data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(data == MAP_FAILED)  PRINT_AND_RETURN("fail to map input file",  OPEN_ERROR);
+
+    num_chunks = split_input(data, size, num_threads, &chunks);
+    if(num_chunks < 0){
+        munmap(data, size);
+        PRINT_AND_RETURN("split_input failed in parse_input",   MALLOC_ERROR);
     }
-
-    // Set up name for the first sequence
-    if(setup_name(&msa_name[sequence_counter], &line[1]) != SUCCESS){ //roll back and deallocate
-        free(msa_core);
-        free(msa_name);
+    madvise(data, size, num_chunks > 1 ? MADV_WILLNEED : MADV_SEQUENTIAL);
+
+    // First pass, then place the chunks one after the other. The aligned length is the length of the first record
+    begin_phase(&phase, "count_chunk");
+    run_chunks(chunks, num_chunks, count_chunk);
+    end_stage(&phase, SUCCESS);
+    num_seq = 0;
+    N = 0;
+    names_size = 0;
+    for(i = 0; i < num_chunks; i++){
+        if(num_seq == 0) N = chunks[i].N;
+        chunks[i].first_row = num_seq;
+        chunks[i].first_name = names_size;
+        num_seq += chunks[i].num_seq;
+        names_size += chunks[i].names_size;
     }
-
-    // Read the stdin line by line until EOF signal
-    while(scanf("%s", line) >= 0){
-        switch(*line){ //read the first character of the word
-            case ';': break;
-            case '>': // Finished previous seuqence
-                if(setup_sequence(&msa_core[sequence_counter], seq) != SUCCESS){ // roll back and deallocate
-                    for(i = 0; i < sequence_counter; i++){
-                        if(i != sequence_counter - 1) free(msa_core[i]);
-                        free(msa_name[i]);
-                    }
-                    free(msa_core);
-                    free(msa_name);
-                    PRINT_AND_RETURN("sequence allocation faiiled in no sequence", MALLOC_ERROR);
-                }
-
-                sequence_counter++;
-                if(setup_name(&msa_name[sequence_counter], &line[1]) != SUCCESS){ // roll back and deallocate
-                    for(i = 0; i < sequence_counter; i++){
-                        free(msa_core[i]);
-                        free(msa_name[i]);
-                    }
-                    free(msa_core);
-                    free(msa_name);
-                    PRINT_AND_RETURN("name allocation faiiled in no sequence", MALLOC_ERROR);
-                }
-                strclr(seq);
-                break;
-            default:
-                strcat(seq, line);
-        }
+    if(num_seq == 0){
+        free(chunks);
+        munmap(data, size);
+        PRINT_AND_RETURN("input file contains no sequence",   GENERAL_ERROR);
     }
 
-    // Final iteration for the last sequence
-    if(setup_sequence(&msa_core[sequence_counter], seq) != SUCCESS){ // roll back and deallocate
-        for(i = 0; i < sequence_counter; i++){
-            if(i != sequence_counter - 1) free(msa_core[i]);
-            free(msa_name[i]);
-        }
-        free(msa_core);
-        free(msa_name);
-        PRINT_AND_RETURN("sequence allocation faiiled in no sequence", MALLOC_ERROR);
+    // Allocate space
+    residues = NULL;
+    if(posix_memalign((void **) &residues, MSA_ALIGNMENT, (size_t) num_seq * msa_stride(N)) != 0) residues = NULL;
+    name_offset = malloc(num_seq * sizeof(int));
+    names = malloc(names_size);
+    if(!residues || !name_offset || !names){
+        free(residues);
+        free(name_offset);
+        free(names);
+        free(chunks);
+        munmap(data, size);
+        PRINT_AND_RETURN("malloc failed in parse_input",    MALLOC_ERROR);
     }
-    sequence_counter++;
-
-    // Close file
-    fclose(f);
+    init_msa(msa_ptr, N, num_seq, residues, name_offset, names);
+
+    // Second pass, which also checks that every row has the aligned length
+    for(i = 0; i < num_chunks; i++) chunks[i].msa = msa_ptr;
+    begin_phase(&phase, "fill_chunk");
+    run_chunks(chunks, num_chunks, fill_chunk);
+    end_stage(&phase, SUCCESS);
+    for(i = 0; i < num_chunks; i++)
+        if(chunks[i].status != SUCCESS){
+            free(chunks);
+            destroy_msa(msa_ptr);
+            munmap(data, size);
+            PRINT_AND_RETURN("fill_input failed in parse_input",    GENERAL_ERROR);
+        }
+    free(chunks);
+    munmap(data, size);
 
-    // Fill in the fields
-    return(init_msa(msa_ptr, strlen(seq), sequence_counter, msa_core, msa_name));
+    if(build_name_index(msa_ptr) != SUCCESS){
+        destroy_msa(msa_ptr);
+        PRINT_AND_RETURN("build_name_index failed in parse_input",  MALLOC_ERROR);
+    }
+    return 0;
 }
 
 
@@ -189,8 +233,9 @@ int write_msa(msa_t * msa, char * filename){
 
     // Write to file
     for(i = 0; i < msa->num_seq; i++){
-        fprintf(f, ">%s\n", msa->name[i]);
-        fprintf(f, "%s\n", msa->msa[i]);
+        fprintf(f, ">%s\n", msa_name(msa, i));
+        fwrite(msa_sequence(msa, i), 1, msa->N, f);
+        fputc('\n', f);
     }
 
     // Close file
@@ -198,197 +243,364 @@ int write_msa(msa_t * msa, char * filename){
     return 0;
 }
 
-/* Extending an original msa to a blank msa with same meta
+/* Extending an original msa to a blank view with same meta. The view shares the storage of the original (or of its parent if the original is a view)
  * Input:   pointer to the two msa
  * Output:  0 on sucess, ERROR otherwise
  * Effect:  calls malloc, set fields in the new msa
  */
 int make_smaller_msa(msa_t * original, msa_t * new){
-    int i, j; //loop variable
-
     // Safe-checking 
     if(!original)           PRINT_AND_RETURN("original is NULL in make_smaller_msa",        GENERAL_ERROR);
     if(!new)                PRINT_AND_RETURN("new is NULL in make_smaller_msa",             GENERAL_ERROR);
 
     new->N          = original->N;
     new->num_seq    = 0;
+    new->stride     = original->stride;
+    new->residues   = NULL;
+    new->name_offset= NULL;
+    new->names      = NULL;
+    new->name_index = NULL;
+    new->index_size = 0;
+    new->parent     = msa_owner(original);
+
+    new->rows       = (int *) malloc(original->num_seq * sizeof(int));
+    if(!new->rows)  PRINT_AND_RETURN("malloc for new->rows failed in make_smaller_msa",     MALLOC_ERROR);
+    return 0;
+}
 
-    new->msa        = (char **) malloc(original->num_seq * sizeof(char *));
-    new->name       = (char **) malloc(original->num_seq * sizeof(char *));
-    if(!new->msa)   PRINT_AND_RETURN("malloc for new->msa failed in make_smaller_msa",      MALLOC_ERROR);
-    if(!new->name)  {
-        free(new->msa);
-        PRINT_AND_RETURN("malloc for new->name failed in make_smaller_msa",     MALLOC_ERROR);
-    }
+/* Resolve every leaf of a tree initialized with read_newick to the row of the msa holding the sequence of the same name
+ * This is the only place where tree names are joined against the msa (through its name index), later stages work with row indices
+ * Input:       the tree and the msa its leaves were built from
+ * Output:      0 on success, ERROR otherwise
+ * Effect:      set leaf_index in the tree
+ */
+int map_leaves_to_msa(tree_t * tree, msa_t * msa){
+    int i; //loop variable
 
-    for(i = 0; i < original->num_seq; i++){
-        new->msa[i]         = (char *) malloc(new->N);
-        new->name[i]        = (char *) malloc(MAX_NAME_LENGTH);
-        if(!new->msa[i]){ //roll back and free all allocated memories 
-            for(j = 0; j < i; j++){
-                free(new->msa[j]);
-                free(new->name[j]);
-            }
-            free(new->msa);
-            free(new->name);
-            PRINT_AND_RETURN("malloc for new msa sequence failed in make_smaller_msa",  MALLOC_ERROR);
-        }
-        if(!new->name[i]){//roll back and free all allocated memories 
-            for(j = 0; j < i; j++){
-                free(new->msa[j]);
-                free(new->name[j]);
-            }
-            free(new->msa[i]);
-            free(new->msa);
-            free(new->name);
-            PRINT_AND_RETURN("malloc for new msa name failed in make_smaller_msa",      MALLOC_ERROR);
+    if(!tree)           PRINT_AND_RETURN("tree is NULL in map_leaves_to_msa",           GENERAL_ERROR);
+    if(!msa)            PRINT_AND_RETURN("msa is NULL in map_leaves_to_msa",            GENERAL_ERROR);
+
+    for(i = 0; i < tree->num_nodes; i++){
+        if(!is_leave(tree, i)) continue;
+        tree->leaf_index[i] = find_row_by_name(msa, tree_name(tree, i));
+        if(tree->leaf_index[i] < 0){
+            printf("%s\n", tree_name(tree, i));
+            PRINT_AND_RETURN("cannot find sequence with said name in map_leaves_to_msa",    GENERAL_ERROR);
         }
-        strclr(new->msa[i]);
-        strclr(new->name[i]);
     }
     return 0;
 }
 
-/* Given a tree initialized with write newick, its centroid edge (from centroid_decomposition) and 2 empty msa structure, 
+/* Given a tree split by centroid_decomposition and 2 empty msa structure, 
  * Fill the 2 msa with leave sequences obtained from breaking the tree into 2 subtrees at the centroid edge
- * Input:       2 centroids (in any order), 2 empty msa with meta set up (in any order) and the original msa
+ * Input:       the tree, 2 empty msa with meta set up (the first one receives the side of the left subtree root) and the original msa
  * Output:      0 on success, ERROR otherwise 
  * Effect:      setting fields in the 2 empty msa and increases its sequence count
  */
-int retrieve_msa_from_root(int centroid1, int centroid2, msa_t * msa1, msa_t * msa2, msa_t * all_msa){
+int retrieve_msa_from_root(tree_t * tree, msa_t * msa1, msa_t * msa2, msa_t * all_msa){
+    int i; //loop variable
+
     // Safe checking 
+    if(!tree)           PRINT_AND_RETURN("tree is NULL in retrieve_msa_from_root",      GENERAL_ERROR);
     if(!msa1)           PRINT_AND_RETURN("msa1 is NULL in retrieve_msa_from_root",      GENERAL_ERROR);
     if(!msa2)           PRINT_AND_RETURN("msa2 is NULL in retrieve_msa_from_root",      GENERAL_ERROR);
     if(!all_msa)        PRINT_AND_RETURN("all_msa is NULL in retrieve_msa_from_root",   GENERAL_ERROR);
+    if(!tree->split_leaves) PRINT_AND_RETURN("tree is not split in retrieve_msa_from_root", GENERAL_ERROR);
 
-    if(!(0 <= centroid1 && centroid1 < maxN)) PRINT_AND_RETURN("centroid1 is out of range in retrieve_msa_from_root",   GENERAL_ERROR);
-    if(!(0 <= centroid2 && centroid2 < maxN)) PRINT_AND_RETURN("centroid2 is out of range in retrieve_msa_from_root",   GENERAL_ERROR);
-    debug_counter = 0;
-    dfs_msa(centroid1, -1, centroid2, all_msa, msa1);
-    dfs_msa(centroid2, -1, centroid1, all_msa, msa2);
+    for(i = 0; i < tree->num_leaves; i++)
+        if(add_to_msa_from_msa(all_msa, i < tree->num_left ? msa1 : msa2, tree->split_leaves[i]) != SUCCESS)
+            PRINT_AND_RETURN("add_to_msa_from_msa failed in retrieve_msa_from_root",     GENERAL_ERROR);
     return 0;
 }
 
-/* Given a file created by hmmsearch, computing the joint likelihood of observing all the sequences in that file by adding up the bitscores
- * Input:       name of the file created by hmmsearch and expected number of sequences in the file
- * Output:      0 on success, ERROR otherwise
- * Effect:      open a file and read its content, call malloc
+//INTERNAL FUNCTIONS IMPLEMENTATIONS
+
+/* Helper to find the name of a sequence in its header line: the first word after '>'
+ * Input:   the header line (without its newline), its length and a pointer to write the length of the name to
+ * Output:  pointer to the start of the name
+ * Effect:  none
  */
-int compute_likelihood(char * filename, int num_seq, float ** likelihood_array){
-    FILE * f;                               //file to be opened
-    char buffer[GENERAL_BUFFER_SIZE];       //placeholder for bit score (must be longer than the longest width of hmmsearch output)
-    int i;                                  //loop variable
-    float cur_ll;                          //storing the resulting likelihood
-
-    // Open file
-    f = fopen(filename, "r");
-    if (!f)                                 PRINT_AND_RETURN("cannot open file to read in compute likelihood",   GENERAL_ERROR);
-
-    while(1){
-        if(fscanf(f, "%s", buffer) < 0) return 0;
-        if(strcmp(buffer, "modified_seq_result") == 0) break;
+char * header_name(char * line, size_t length, size_t * name_length){
+    size_t start, end;
+
+    for(start = 1; start < length && isspace((unsigned char) line[start]); start++);
+    for(end = start; end < length && !isspace((unsigned char) line[end]); end++);
+    *name_length = end - start;
+    return line + start;
+}
+
+/* Helper to copy the residues of one sequence line, that is all of its non whitespace characters
+ * Lines without blanks (the common case) are copied with a single memcpy
+ * Input:   the line (without its newline), its length, where to copy the residues to (NULL to only count them) 
+ *          and the room left there
+ * Output:  number of residues in the line, nothing is copied beyond the room left
+ * Effect:  write to out
+ */
+size_t copy_residues(char * line, size_t length, char * out, size_t room){
+    size_t i, count; //loop variables
+
+    while(length && isspace((unsigned char) line[length - 1])) length--;
+    if(!memchr(line, ' ', length) && !memchr(line, '\t', length) && !memchr(line, '\r', length)){
+        if(out) memcpy(out, line, length < room ? length : room);
+        return length;
     }
 
-    *likelihood_array        = malloc(num_seq * sizeof(float));
-    if(!*likelihood_array)                  PRINT_AND_RETURN("malloc failure",     MALLOC_ERROR);
+    for(i = count = 0; i < length; i++){
+        if(isspace((unsigned char) line[i])) continue;
+        if(out && count < room) out[count] = line[i];
+        count++;
+    }
+    return count;
+}
 
-    for(i = 0; i < num_seq; i++){
-        // Skip this line
-        fscanf(f, "%f", &cur_ll);
-        likelihood_array[0][i] = cur_ll;
-        if(i != num_seq - 1) fscanf(f, "%s", buffer);
+/* Find the start of the first record beginning at or after a position, that is a '>' at the start of a line
+ * Input:   the content of the FASTA file, its size and the position to search from
+ * Output:  the position of the record, size if there is none
+ * Effect:  none
+ */
+size_t next_record(char * data, size_t size, size_t pos){
+    char * newline;
+
+    if(pos == 0) return 0;
+    while(pos < size){
+        if(data[pos] == '>' && data[pos - 1] == '\n') return pos;
+        newline = memchr(data + pos, '\n', size - pos);
+        if(!newline) return size;
+        pos = newline - data + 1;
     }
+    return size;
+}
 
-    // Close the file
-    fclose(f);
+/* Cut the FASTA file into chunks of about equal size, each starting on a record (except the first one that starts the file)
+ * Small files are not cut below MIN_CHUNK_SIZE per chunk
+ * Input:   the content of the FASTA file, its size, the number of threads and a pointer to receive the chunks
+ * Output:  the number of chunks, MALLOC_ERROR on failure
+ * Effect:  calls malloc for the chunks
+ */
+int split_input(char * data, size_t size, int num_threads, input_chunk_t ** chunks){
+    int num_chunks;
+    size_t begin, end;
+    int i; //loop variable
 
-    return 0;
+    num_chunks = num_threads;
+    if((size_t) num_chunks > size / MIN_CHUNK_SIZE) num_chunks = size / MIN_CHUNK_SIZE;
+    if(num_chunks < 1) num_chunks = 1;
+
+    *chunks = malloc(num_chunks * sizeof(input_chunk_t));
+    if(!*chunks) return MALLOC_ERROR;
+
+    for(i = 0, begin = 0; i < num_chunks; i++, begin = end){
+        end = i == num_chunks - 1 ? size : next_record(data, size, size / num_chunks * (i + 1));
+        if(end < begin) end = begin;
+        (*chunks)[i].data = data + begin;
+        (*chunks)[i].size = end - begin;
+        (*chunks)[i].msa = NULL;
+        (*chunks)[i].status = SUCCESS;
+    }
+    return num_chunks;
 }
 
+/* Run one pass on every chunk, the first chunk on the calling thread and the others on their own threads
+ * A chunk whose thread cannot be started is run on the calling thread
+ * Input:   the chunks, their number and the pass
+ * Output:  nothing
+ * Effect:  the effects of the pass on every chunk
+ */
+void run_chunks(input_chunk_t * chunks, int num_chunks, void * (*pass)(void *)){
+    pthread_t threads[num_chunks];
+    int started[num_chunks];
+    int i; //loop variable
 
-//INTERNAL FUNCTIONS IMPLEMENTATIONS
+    for(i = 1; i < num_chunks; i++)
+        started[i] = pthread_create(&threads[i], NULL, pass, &chunks[i]) == 0;
+    pass(&chunks[0]);
+    for(i = 1; i < num_chunks; i++){
+        if(started[i])  pthread_join(threads[i], NULL);
+        else            pass(&chunks[i]);
+    }
+}
 
-/* Wrapper to malloc name holder and copy name into that place
- * Input:   the name and the location to be copied to
- * Output:  0 on success, ERROR otherwise   
- * Effect:  calls malloc
+/* Thread entries of the two passes of parse_input on one chunk
+ * Input:   the chunk
+ * Output:  NULL, the result is stored in the chunk
+ * Effect:  see count_input and fill_input
  */
-int setup_name(char ** name_holder, char* name){
-    if(!name)   PRINT_AND_RETURN("name is NULL when trying to parse",   GENERAL_ERROR);
+void * count_chunk(void * chunk){
+    input_chunk_t * c = chunk;
+    c->status = count_input(c->data, c->size, &c->num_seq, &c->N, &c->names_size);
+    return NULL;
+}
 
-    *name_holder = (char *) malloc(strlen(name));
-    if(!*name_holder) PRINT_AND_RETURN("malloc failed for name holder", MALLOC_ERROR);
-    strcpy(*name_holder, name);
+void * fill_chunk(void * chunk){
+    input_chunk_t * c = chunk;
+    c->status = fill_input(c->data, c->size, c->msa, c->first_row, c->first_name);
+    return NULL;
+}
+
+/* First pass of parse_input on a chunk: count the sequences, the length of the first sequence and the size of the names
+ * Lines starting with ';' and lines before the first '>' are ignored
+ * Input:   a chunk of the FASTA file, its size and pointers to write the counts to
+ * Output:  0 on success
+ * Effect:  none
+ */
+int count_input(char * data, size_t size, int * num_seq, int * N, size_t * names_size){
+    size_t pos, end, name_length;
+    char * newline;
+
+    *num_seq = 0;
+    *N = 0;
+    *names_size = 0;
+    for(pos = 0; pos < size; pos = end + 1){
+        newline = memchr(data + pos, '\n', size - pos);
+        end = newline ? (size_t) (newline - data) : size;
+
+        switch(data[pos]){
+            case ';': break;
+            case '>':
+                (*num_seq)++;
+                header_name(data + pos, end - pos, &name_length);
+                *names_size += name_length + 1;
+                break;
+            default:
+                if(*num_seq == 1) *N += copy_residues(data + pos, end - pos, NULL, 0);
+        }
+    }
     return 0;
 }
 
-/* Wrapper to malloc sequence holder and copy sequence into that place
- * Input:   the sequence and the location to be copied to
- * Output:  0 on success, ERROR otherwise   
- * Effect:  calls malloc
+/* Second pass of parse_input on a chunk: copy the names and the residues into storage sized by count_input
+ * Input:   a chunk of the FASTA file, its size, the msa with its storage allocated, 
+ *          the row of the first record of the chunk and the offset of its name in the name arena
+ * Output:  0 on success, ERROR otherwise (in particular if the sequences are not all of the same length)
+ * Effect:  fill the residues, names and name offsets of the rows of the chunk
  */
-int setup_sequence(char ** sequence_holder, char* sequence){
-    // The syntax is exactly the same as setup_name so we will just call that function instead
-    return setup_name(sequence_holder, sequence);
+int fill_input(char * data, size_t size, msa_t * msa, int first_row, size_t first_name){
+    size_t pos, end, name_length;
+    char * newline;
+    char * name;
+    char * sequence = NULL;
+    int row = first_row - 1;
+    size_t length = 0;
+    size_t names_length = first_name;
+
+    for(pos = 0; pos < size; pos = end + 1){
+        newline = memchr(data + pos, '\n', size - pos);
+        end = newline ? (size_t) (newline - data) : size;
+
+        switch(data[pos]){
+            case ';': break;
+            case '>': // Finished previous seuqence
+                if(row >= first_row && finish_sequence(msa, row, length) != SUCCESS)   return GENERAL_ERROR;
+                row++;
+
+                name = header_name(data + pos, end - pos, &name_length);
+                msa->name_offset[row] = names_length;
+                memcpy(msa->names + names_length, name, name_length);
+                msa->names[names_length + name_length] = 0;
+                names_length += name_length + 1;
+
+                sequence = msa_sequence(msa, row);
+                length = 0;
+                break;
+            default:
+                if(row < first_row) break; // ignoring comments before the first sequence
+                length += copy_residues(data + pos, end - pos, sequence + length, length < (size_t) msa->N ? msa->N - length : 0);
+        }
+    }
+    if(row < first_row) return 0; // no record in this chunk
+    return finish_sequence(msa, row, length);
 }
 
+/* Check the length of a sequence just read and clear the padding after it (which also null terminates it)
+ * Input:   the msa, the row of the sequence and the number of residues read for it
+ * Output:  0 on success, ERROR if the length differs from the aligned length N
+ * Effect:  write the padding of the row
+ */
+int finish_sequence(msa_t * msa, int row, size_t length){
+    if(length != (size_t) msa->N){
+        printf("sequence %s has %zu residues instead of %d\n", msa_name(msa, row), length, msa->N);
+        PRINT_AND_RETURN("sequences are not aligned",   GENERAL_ERROR);
+    }
+    memset(msa_sequence(msa, row) + msa->N, 0, msa->stride - msa->N);
+    return 0;
+}
 
-/* Brute force algorithm to find sequence based on name
- * Input:   msa structure and the name of the sequence
- * Output:  pointer to the sequence on success, NULL otherwise
+/* FNV-1a hash of a name
+ * Input:   null terminated name
+ * Output:  the hash value
  * Effect:  none
  */
-char * find_sequence_by_name(msa_t * msa, char * name){
-    int i; //loop variable
-
-    if(!msa)        PRINT_AND_RETURN("msa is NULL in find_sequence_by_name",    NULL);
-    if(!name)       PRINT_AND_RETURN("name is NULL in find_sequence_by_name",   NULL);
-    for(i = 0; i < msa->num_seq; i++)
-        if(strcmp(name, msa->name[i]) == 0)
-            return msa->msa[i];
-    return NULL;
+unsigned int hash_name(char * name){
+    unsigned int h = 2166136261u;
+    for(; *name; name++){
+        h ^= (unsigned char) *name;
+        h *= 16777619u;
+    }
+    return h;
 }
 
-/* Brute force algorithm to add a sequence from an msa struct to another msa struct
- * Input:   both msa structures and the name of the sequence
+/* Build the open addressing (linear probing) hash index from name to row, with at most half of the slots filled
+ * If a name appears more than once, the first row keeps it
+ * Input:   msa structure with all the names set
  * Output:  0 on success, ERROR otherwise
- * Effect:  set fields in the new msa
+ * Effect:  calls malloc, set name_index and index_size in the msa
  */
-int add_to_msa_from_msa(msa_t * original, msa_t * new, char * name){
-    char * sequence; //hold the pointer to the sequene to be copied
+int build_name_index(msa_t * msa){
+    int i, slot; //loop variables
 
-    if(!original)   PRINT_AND_RETURN("original is NULL in add_to_msa_from_msa", GENERAL_ERROR);
-    if(!new)        PRINT_AND_RETURN("new is NULL in add_to_msa_from_msa",      GENERAL_ERROR);
-    if(!name)       PRINT_AND_RETURN("name is NULL in add_to_msa_from_msa",     GENERAL_ERROR);
+    if(!msa)        PRINT_AND_RETURN("msa is NULL in build_name_index",         GENERAL_ERROR);
 
-    sequence = find_sequence_by_name(original, name);
-    if(!sequence)   PRINT_AND_RETURN("cannot find sequence with said name in add_to_msa_from_msa",      GENERAL_ERROR);
+    free(msa->name_index);
+    for(msa->index_size = 16; msa->index_size < 2 * msa->num_seq; msa->index_size *= 2);
+    msa->name_index = malloc(msa->index_size * sizeof(int));
+    if(!msa->name_index)    PRINT_AND_RETURN("malloc failed for name_index in build_name_index",    MALLOC_ERROR);
+    memset(msa->name_index, -1, msa->index_size * sizeof(int));
 
-    strcpy(new->msa[new->num_seq], sequence);
-    strcpy(new->name[new->num_seq], name);
-    new->num_seq++;
+    for(i = 0; i < msa->num_seq; i++){
+        for(slot = hash_name(msa_name(msa, i)) & (msa->index_size - 1); msa->name_index[slot] != -1; slot = (slot + 1) & (msa->index_size - 1))
+            if(strcmp(msa_name(msa, msa->name_index[slot]), msa_name(msa, i)) == 0) break;
+        if(msa->name_index[slot] == -1) msa->name_index[slot] = i;
+    }
     return 0;
 }
 
-/* DFS for traversing the tree from one centroid edge avoiding the other, adding the msa at each leave traversed to a provided msa.
- * Input:       cur_node    numeric node in the tree (not names) currently at
- *              par_node    numeric node of the parents last visited (instead of an array of visited nodes)
- *              all_msa     the original msa where the sequences come from
- *              small_msa   the new msa to which the sequences are added 
- * Output:  none
- * Effect:  write to the small_msa, incrementing its node count
+/* Find the row of a sequence based on name, through the name index if it was built and by brute force otherwise
+ * Input:   msa structure and the name of the sequence
+ * Output:  index of the sequence on success, -1 otherwise
+ * Effect:  none
  */
-void dfs_msa(int cur_node, int par_node, int centroid, msa_t * all_msa, msa_t * small_msa){
-    // printf("%d %s\n", ++debug_counter, name_map[cur_node]);
+int find_row_by_name(msa_t * msa, char * name){
+    int i, slot; //loop variables
 
-    if(is_leave(cur_node)) add_to_msa_from_msa(all_msa, small_msa, name_map[cur_node]);
-    for(int i = 0; i < maxN; i++){
-        if(!adj_mat[cur_node][i] || i == par_node || i == cur_node || i == centroid) continue;
+    if(!msa)        PRINT_AND_RETURN("msa is NULL in find_row_by_name",         -1);
+    if(!name)       PRINT_AND_RETURN("name is NULL in find_row_by_name",        -1);
 
-        dfs_msa(i, cur_node, centroid, all_msa, small_msa);
+    if(msa->name_index){
+        for(slot = hash_name(name) & (msa->index_size - 1); msa->name_index[slot] != -1; slot = (slot + 1) & (msa->index_size - 1))
+            if(strcmp(name, msa_name(msa, msa->name_index[slot])) == 0)
+                return msa->name_index[slot];
+        return -1;
     }
-}
-
 
+    for(i = 0; i < msa->num_seq; i++)
+        if(strcmp(name, msa_name(msa, i)) == 0)
+            return i;
+    return -1;
+}
 
+/* Add a sequence from an msa struct to a view made by make_smaller_msa. Only the row index is recorded
+ * Input:   both msa structures and the row of the sequence in the original msa
+ * Output:  0 on success, ERROR otherwise
+ * Effect:  set fields in the new msa
+ */
+int add_to_msa_from_msa(msa_t * original, msa_t * new, int row){
+    if(!original)   PRINT_AND_RETURN("original is NULL in add_to_msa_from_msa", GENERAL_ERROR);
+    if(!new)        PRINT_AND_RETURN("new is NULL in add_to_msa_from_msa",      GENERAL_ERROR);
+    if(!new->rows || new->parent != msa_owner(original))
+                    PRINT_AND_RETURN("new is not a view of original in add_to_msa_from_msa",    GENERAL_ERROR);
+    if(!(0 <= row && row < original->num_seq))
+                    PRINT_AND_RETURN("row is out of range in add_to_msa_from_msa",  GENERAL_ERROR);
 
+    new->rows[new->num_seq++] = msa_row(original, row);
+    return 0;
+}
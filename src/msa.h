@@ -3,36 +3,51 @@
 #ifndef MSA_H
 #define MSA_H
 
-// Constants
-const static int MAX_SEQUENCE_LENGTH    = (int) 1e6;
-const static int MAX_NUM_SEQUENCE       = (int) 1e6;
-const static int MAX_NAME_LENGTH        = (int) 1e3;
+#include "tree.h"
+
+// Alignment of the residue matrix and of its rows (a cache line, wide enough for any vector unit)
+#define MSA_ALIGNMENT           64
+
+// Distance in bytes between consecutive sequences of length N (room for the null terminator, rounded up to the alignment)
+#define msa_stride(N)           ((((N) + 1) + MSA_ALIGNMENT - 1) / MSA_ALIGNMENT * MSA_ALIGNMENT)
 
 // Structure for the multiple sequence alignment
+// An msa either owns its sequences or is a view holding the indices of some rows of a parent msa that owns them
+// The sequences of an owning msa are the rows of one contiguous residue matrix and the names live in one arena
 typedef struct msa {
     int     N;          // size of one sequence
     int     num_seq;    // number of sequences
-    char**  msa;
-    char**  name;
+    int     stride;     // distance in bytes between consecutive sequences in residues
+    char*   residues;   // num_seq x stride residue matrix aligned to MSA_ALIGNMENT, rows are null terminated and zero padded, NULL for a view
+    int*    name_offset;// offset of the name of each sequence in names, NULL for a view
+    char*   names;      // name arena holding the null terminated names, NULL for a view
+    int*    name_index; // open addressing hash table from name to row (-1 for empty slots), NULL if not built
+    int     index_size; // number of slots in name_index, a power of 2
+    struct msa* parent; // msa owning the rows of a view, NULL if the msa owns its rows
+    int*    rows;       // row in the parent of each sequence of a view, NULL if the msa owns its rows
 } msa_t;
 
+// Accessors working for both owning msa and views
+#define msa_owner(m)            ((m)->parent ? (m)->parent : (m))
+#define msa_row(m, i)           ((m)->rows ? (m)->rows[i] : (i))
+#define msa_sequence(m, i)      (msa_owner(m)->residues + (size_t) msa_row(m, i) * msa_owner(m)->stride)
+#define msa_name(m, i)          (msa_owner(m)->names + msa_owner(m)->name_offset[msa_row(m, i)])
+
 // Public functions. Details are in definition
 
 // Constructor & destructor
-extern int init_msa(msa_t* msa, int N, int num_seq, char** msa_core,  char** msa_name);
+extern int init_msa(msa_t* msa, int N, int num_seq, char* residues, int* name_offset, char* names);
 extern void destroy_msa(msa_t * msa);
 
 // IO functions
-extern int parse_input(msa_t * msa, char * filename);
+extern int parse_input(msa_t * msa, char * filename, int num_threads);
 extern int write_msa(msa_t * msa, char * filename);
 
 // Extending to a new MSA
 extern int make_smaller_msa(msa_t * original, msa_t * new);
 
 // With tree 
-extern int retrieve_msa_from_root(int centroid1, int centroid2, msa_t * msa1, msa_t * msa2, msa_t * all_msa);
-
-// Read likelihood from hmmsearch
-extern int compute_likelihood(char * filename, int num_seq, float ** likelihood_array);
+extern int map_leaves_to_msa(tree_t * tree, msa_t * msa);
+extern int retrieve_msa_from_root(tree_t * tree, msa_t * msa1, msa_t * msa2, msa_t * all_msa);
 
 #endif
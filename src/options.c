@@ -3,62 +3,41 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #include "options.h"
 #include "utilities.h"
 
 
 // Constants
-int DEFAULT_NUM_OPTIONS = 3;
+int DEFAULT_NUM_OPTIONS = 19;
 
-char DEFAULT_SINGLE_HMM_NAME             []  = "defaultjob.single_hmm";
-char DEFAULT_SYMFRAC                     []  = "--symfrac=0.0";
-char DEFAULT_HMM_MOLECULE                []  = "--dna";
+char DEFAULT_OUTPUT_PREFIX               []  = "defaultjob";
+char DEFAULT_WORK_DIR                    []  = "decide.XXXXXX";
 
-char DEFAULT_TREE_OUTPUT                 []  = "defaultjob.fasttree.out";
+char SINGLE_HMM_SUFFIX                   []  = "single_hmm";
+
+char TREE_OUTPUT_SUFFIX                  []  = "fasttree.out";
 char DEFAULT_TREE_MODEL                  []  = "-gtr";
 char DEFAULT_TREE_MOLECULE               []  = "-nt";
 char DEFAULT_SUPPORT                     []  = "-nosupport";
 
-char DEFAULT_DOUBLE_FIRST_HMM_NAME       []  = "defaultjob.double_first_hmm";
-char DEFAULT_DOUBLE_SECOND_HMM_NAME      []  = "defaultjob.double_second_hmm";
-char DEFAULT_DOUBLE_FIRST_MSA_NAME       []  = "defaultjob.double_first_msa";
-char DEFAULT_DOUBLE_SECOND_MSA_NAME      []  = "defaultjob.double_second_msa";
-
-char DEFAULT_NOALI                       []  = "--noali";
-char DEFAULT_HEURISTICS_FILTER           []  = "--max";
-char DEFAULT_E_VAL                       []  = "-E Infinity";
-
-char DEFAULT_SINGLE_SEARCH_NAME          []  = "defaultjob.single_search_out";
-char DEFAULT_DOUBLE_FIRST_SEARCH_NAME    []  = "defaultjob.double_first_search_out";
-char DEFAULT_DOUBLE_SECOND_SEARCH_NAME   []  = "defaultjob.double_second_search_out";
-
-char DEFAULT_SINGLE_SEARCH_FLAG          []  = "--tblout defaultjob.single_search_out";
-char DEFAULT_DOUBLE_FIRST_SEARCH_FLAG    []  = "--tblout defaultjob.double_first_search_out";
-char DEFAULT_DOUBLE_SECOND_SEARCH_FLAG   []  = "--tblout defaultjob.double_second_search_out";
-
-char DEFAULT_HMMBUILD_OUT_SINGLE_NAME    []  = "defaultjob.hmmbuild_single.stdout";
-
-char DEFAULT_HMMBUILD_OUT_SINGLE         []  = "defaultjob.hmmbuild_single.stdout";
-char DEFAULT_HMMBUILD_OUT_FIRST_DOUBLE   []  = "defaultjob.hmmbuild_first_double.stdout";
-char DEFAULT_HMMBUILD_OUT_SECOND_DOUBLE  []  = "defaultjob.hmmbuild_second_double.stdout";
-
-char DEFAULT_HMMSEARCH_OUT_SINGLE         []  = "defaultjob.hmmsearch_single.stdout";
-char DEFAULT_HMMSEARCH_OUT_FIRST_DOUBLE   []  = "defaultjob.hmmsearch_first_double.stdout";
-char DEFAULT_HMMSEARCH_OUT_SECOND_DOUBLE  []  = "defaultjob.hmmsearch_second_double.stdout";
+char DOUBLE_FIRST_HMM_SUFFIX             []  = "double_first_hmm";
+char DOUBLE_SECOND_HMM_SUFFIX            []  = "double_second_hmm";
+char DOUBLE_FIRST_MSA_SUFFIX             []  = "double_first_msa";
+char DOUBLE_SECOND_MSA_SUFFIX            []  = "double_second_msa";
 
-// Fields                                                               input_name                      symfrac             output_name                     molecule_name                       
-hmmbuild_option_t        single_model_build_option           = { NULL,                           DEFAULT_SYMFRAC,    DEFAULT_SINGLE_HMM_NAME,        DEFAULT_HMM_MOLECULE,   DEFAULT_HMMBUILD_OUT_SINGLE};
-hmmbuild_option_t        double_model_first_build_option     = { DEFAULT_DOUBLE_FIRST_MSA_NAME,  DEFAULT_SYMFRAC,    DEFAULT_DOUBLE_FIRST_HMM_NAME,  DEFAULT_HMM_MOLECULE,   DEFAULT_HMMBUILD_OUT_FIRST_DOUBLE};
-hmmbuild_option_t        double_model_second_build_option    = { DEFAULT_DOUBLE_SECOND_MSA_NAME, DEFAULT_SYMFRAC,    DEFAULT_DOUBLE_SECOND_HMM_NAME, DEFAULT_HMM_MOLECULE,   DEFAULT_HMMBUILD_OUT_SECOND_DOUBLE};
+char SINGLE_STATE_SUFFIX                 []  = "single_hmm.state";
+char DOUBLE_FIRST_STATE_SUFFIX           []  = "double_first_hmm.state";
+char DOUBLE_SECOND_STATE_SUFFIX          []  = "double_second_hmm.state";
+char SINGLE_SCORES_SUFFIX                []  = "single_scores";
+char DOUBLE_FIRST_SCORES_SUFFIX          []  = "double_first_scores";
+char DOUBLE_SECOND_SCORES_SUFFIX         []  = "double_second_scores";
 
-// Fields                                                           input_sequences_name            input_hmm_name                  output_name                         no_ali_option       e_value_threshold       heuristics_filtering_threshold      
-hmmsearch_options_t  single_model_search_option          = { NULL,                           DEFAULT_SINGLE_HMM_NAME,        DEFAULT_SINGLE_SEARCH_FLAG,         DEFAULT_NOALI,      DEFAULT_E_VAL,          DEFAULT_HEURISTICS_FILTER,              DEFAULT_HMMSEARCH_OUT_SINGLE}; 
-hmmsearch_options_t  double_model_fist_search_option     = { DEFAULT_DOUBLE_FIRST_MSA_NAME,  DEFAULT_DOUBLE_FIRST_HMM_NAME,  DEFAULT_DOUBLE_FIRST_SEARCH_FLAG,   DEFAULT_NOALI,      DEFAULT_E_VAL,          DEFAULT_HEURISTICS_FILTER,              DEFAULT_HMMSEARCH_OUT_FIRST_DOUBLE}; 
-hmmsearch_options_t  double_model_second_search_option   = { DEFAULT_DOUBLE_SECOND_MSA_NAME, DEFAULT_DOUBLE_SECOND_HMM_NAME, DEFAULT_DOUBLE_SECOND_SEARCH_FLAG,  DEFAULT_NOALI,      DEFAULT_E_VAL,          DEFAULT_HEURISTICS_FILTER,              DEFAULT_HMMSEARCH_OUT_SECOND_DOUBLE}; 
+char DEFAULT_RESULTS_NAME                []  = "decide.tsv";
 
-// Fields                                       input_name      output_name             model_name              molecule_name               support
-fasttree_options_t fasttree_options  = { NULL,           DEFAULT_TREE_OUTPUT,    DEFAULT_TREE_MODEL,     DEFAULT_TREE_MOLECULE,      DEFAULT_SUPPORT};
+// Fields, the input and output names are set for each alignment   input_name      output_name             model_name              molecule_name               support
+fasttree_options_t fasttree_options  = { NULL,           NULL,                   DEFAULT_TREE_MODEL,     DEFAULT_TREE_MOLECULE,      DEFAULT_SUPPORT};
 
 /* Function to check the flag tag and assign its content to the appropriate field in option structure
  * This function also stores the index in argv to the content
@@ -69,7 +48,7 @@ fasttree_options_t fasttree_options  = { NULL,           DEFAULT_TREE_OUTPUT,
 int find_arg_index(char * flag, char * content, option_t * options, int i){
     if(strcmp(flag, "-i") == 0){//reading input name
         options->input_index = i;
-        options->input_name = malloc(strlen(content));  
+        options->input_name = malloc(strlen(content) + 1);  
 
         if(!options->input_name)        
             PRINT_AND_RETURN("malloc failure for input name in find_arg_index",     MALLOC_ERROR);
@@ -78,7 +57,7 @@ int find_arg_index(char * flag, char * content, option_t * options, int i){
 
     } else if(strcmp(flag, "-o") == 0){
         options->output_index = i;
-        options->output_name = malloc(strlen(content));
+        options->output_name = malloc(strlen(content) + 1);
 
         if(!options->output_name)       
             PRINT_AND_RETURN("malloc failure for output name in find_arg_index",    MALLOC_ERROR);
@@ -87,12 +66,128 @@ int find_arg_index(char * flag, char * content, option_t * options, int i){
 
     } else if(strcmp(flag, "--symfrac") == 0){
         options->symfrac_index = i;
-        options->symfrac = malloc(strlen(content));
+        options->symfrac = malloc(strlen(content) + 1);
 
         if(!options->symfrac)           
             PRINT_AND_RETURN("malloc failure for symfrac in find_arg_index",        MALLOC_ERROR);
         else
             strcpy(options->symfrac, content);
+
+    } else if(strcmp(flag, "--threads") == 0){
+        options->threads_index = i;
+        options->num_threads = atoi(content);
+
+        if(options->num_threads < 1)
+            PRINT_AND_RETURN("number of threads must be positive in find_arg_index",    GENERAL_ERROR);
+
+    } else if(strcmp(flag, "--jobs") == 0){
+        options->jobs_index = i;
+        options->num_jobs = atoi(content);
+
+        if(options->num_jobs < 1)
+            PRINT_AND_RETURN("number of jobs must be positive in find_arg_index",       GENERAL_ERROR);
+
+    } else if(strcmp(flag, "--score") == 0){
+        options->score_index = i;
+        options->score_mode = malloc(strlen(content) + 1);
+
+        if(!options->score_mode)
+            PRINT_AND_RETURN("malloc failure for score mode in find_arg_index",     MALLOC_ERROR);
+        else
+            strcpy(options->score_mode, content);
+
+    } else if(strcmp(flag, "--band") == 0){
+        options->band_index = i;
+        options->band = atoi(content);
+
+        if(options->band < 1)
+            PRINT_AND_RETURN("band must be positive in find_arg_index",             GENERAL_ERROR);
+
+    } else if(strcmp(flag, "--batch") == 0){
+        options->batch_index = i;
+        options->batch_name = malloc(strlen(content) + 1);
+
+        if(!options->batch_name)
+            PRINT_AND_RETURN("malloc failure for batch name in find_arg_index",     MALLOC_ERROR);
+        else
+            strcpy(options->batch_name, content);
+
+    } else if(strcmp(flag, "--results") == 0){
+        options->results_index = i;
+        options->results_name = malloc(strlen(content) + 1);
+
+        if(!options->results_name)
+            PRINT_AND_RETURN("malloc failure for results name in find_arg_index",   MALLOC_ERROR);
+        else
+            strcpy(options->results_name, content);
+
+    } else if(strcmp(flag, "--serve") == 0){
+        options->serve_index = i;
+        options->serve_name = malloc(strlen(content) + 1);
+
+        if(!options->serve_name)
+            PRINT_AND_RETURN("malloc failure for socket name in find_arg_index",    MALLOC_ERROR);
+        else
+            strcpy(options->serve_name, content);
+
+    } else if(strcmp(flag, "--client") == 0){
+        options->client_index = i;
+        options->client_name = malloc(strlen(content) + 1);
+
+        if(!options->client_name)
+            PRINT_AND_RETURN("malloc failure for socket name in find_arg_index",    MALLOC_ERROR);
+        else
+            strcpy(options->client_name, content);
+
+    } else if(strcmp(flag, "--requests") == 0){
+        options->requests_index = i;
+        options->num_requests = atoi(content);
+
+        if(options->num_requests < 1)
+            PRINT_AND_RETURN("number of requests must be positive in find_arg_index",   GENERAL_ERROR);
+
+    } else if(strcmp(flag, "--cache") == 0){
+        options->cache_index = i;
+        options->cache_name = malloc(strlen(content) + 1);
+
+        if(!options->cache_name)
+            PRINT_AND_RETURN("malloc failure for cache name in find_arg_index",     MALLOC_ERROR);
+        else
+            strcpy(options->cache_name, content);
+
+    } else if(strcmp(flag, "--cache-size") == 0){
+        options->cache_size_index = i;
+        options->cache_size = atol(content);
+
+        if(options->cache_size < 1)
+            PRINT_AND_RETURN("cache size must be positive in find_arg_index",       GENERAL_ERROR);
+
+    } else if(strcmp(flag, "--profile") == 0){
+        options->profile_index = i;
+        options->profile_name = malloc(strlen(content) + 1);
+
+        if(!options->profile_name)
+            PRINT_AND_RETURN("malloc failure for profile name in find_arg_index",   MALLOC_ERROR);
+        else
+            strcpy(options->profile_name, content);
+
+    } else if(strcmp(flag, "--trace") == 0){
+        options->trace_index = i;
+        options->trace_name = malloc(strlen(content) + 1);
+
+        if(!options->trace_name)
+            PRINT_AND_RETURN("malloc failure for trace name in find_arg_index",     MALLOC_ERROR);
+        else
+            strcpy(options->trace_name, content);
+
+    } else if(strcmp(flag, "--kernel") == 0){
+        options->kernel_index = i;
+        options->kernel = malloc(strlen(content) + 1);
+
+        if(!options->kernel)
+            PRINT_AND_RETURN("malloc failure for kernel in find_arg_index",         MALLOC_ERROR);
+        else
+            strcpy(options->kernel, content);
     } else PRINT_AND_RETURN("unrecognized argument", GENERAL_ERROR); 
 
     return 0;
@@ -111,11 +206,21 @@ int read_cmd_arg(int argc, char ** argv, option_t * options){
     if(!argc % 2 || !(1 < argc && argc < 2 * options->num_options + 2)) 
         PRINT_AND_RETURN("incorrect number of argument", GENERAL_ERROR);
 
-    // Loop through command
-    for(int i = 0; i < argc; i++)
-        if(i != 0 && i % 2) //currently reading a flag
-            if(find_arg_index(argv[i], argv[i + 1], options, i) != SUCCESS)
-                PRINT_AND_RETURN("failed reading of the arguments", GENERAL_ERROR);
+    // Loop through command, every flag but --keep-intermediates and --resume is followed by its content
+    for(int i = 1; i < argc; i += 2){
+        if(strcmp(argv[i], "--keep-intermediates") == 0){
+            options->keep_index = i--;
+            continue;
+        }
+        if(strcmp(argv[i], "--resume") == 0){
+            options->resume_index = i--;
+            continue;
+        }
+        if(i + 1 >= argc)
+            PRINT_AND_RETURN("missing content for the last flag", GENERAL_ERROR);
+        if(find_arg_index(argv[i], argv[i + 1], options, i) != SUCCESS)
+            PRINT_AND_RETURN("failed reading of the arguments", GENERAL_ERROR);
+    }
 
     return 0;
 }
@@ -131,10 +236,44 @@ int init_options(option_t * options){
     options->input_index = -1;
     options->output_index = -1;
     options->symfrac_index = -1;
+    options->threads_index = -1;
+    options->jobs_index = -1;
+    options->score_index = -1;
+    options->band_index = -1;
+    options->kernel_index = -1;
+    options->keep_index = -1;
+    options->resume_index = -1;
+    options->batch_index = -1;
+    options->results_index = -1;
+    options->serve_index = -1;
+    options->client_index = -1;
+    options->requests_index = -1;
+    options->cache_index = -1;
+    options->cache_size_index = -1;
+    options->profile_index = -1;
+    options->trace_index = -1;
 
     options->input_name = NULL;
     options->output_name = NULL;
+    options->output_prefix = NULL;
     options->symfrac = NULL;
+    options->score_mode = NULL;
+    options->kernel = NULL;
+    options->batch_name = NULL;
+    options->results_name = NULL;
+    options->serve_name = NULL;
+    options->client_name = NULL;
+    options->cache_name = NULL;
+    options->profile_name = NULL;
+    options->trace_name = NULL;
+    options->band = DEFAULT_BAND;
+    options->cache_size = DEFAULT_CACHE_SIZE;
+    options->num_requests = DEFAULT_NUM_REQUESTS;
+
+    // Default to one thread and one external job per online core
+    options->num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    if(options->num_threads < 1) options->num_threads = 1;
+    options->num_jobs = options->num_threads;
 
     return 0;
 }
@@ -150,6 +289,58 @@ void destroy_options(option_t * options){
     if(options->input_name)     free(options->input_name);
     if(options->output_name)    free(options->output_name);
     if(options->symfrac)        free(options->symfrac);
+    if(options->score_mode)     free(options->score_mode);
+    if(options->kernel)         free(options->kernel);
+    if(options->output_prefix)  free(options->output_prefix);
+    if(options->batch_name)     free(options->batch_name);
+    if(options->results_name)   free(options->results_name);
+    if(options->serve_name)     free(options->serve_name);
+    if(options->client_name)    free(options->client_name);
+    if(options->cache_name)     free(options->cache_name);
+    if(options->profile_name)   free(options->profile_name);
+    if(options->trace_name)     free(options->trace_name);
+    options->output_prefix = options->batch_name = options->results_name = NULL;
+    options->serve_name = options->client_name = options->cache_name = options->profile_name = options->trace_name = NULL;
+
+    options->input_index = options->output_index = options->symfrac_index = options->threads_index = options->jobs_index = 0;
+    options->score_index = options->band_index = options->kernel_index = options->keep_index = options->resume_index = 0;
+    options->batch_index = options->results_index = 0;
+    options->serve_index = options->client_index = options->requests_index = 0;
+    options->cache_index = options->cache_size_index = options->profile_index = options->trace_index = 0;
+}
 
-    options->input_index = options->output_index = options->symfrac_index = 0;
-}
\ No newline at end of file
+/* Prefix of every intermediate file: the output prefix (-o), or a new directory unique to the run when there is none,
+ * so that runs sharing a working directory never write to the same file
+ * Input    pointer to the option struct
+ * Output   0 on success, ERROR otherwise
+ * Effect   calls malloc, may create a directory, set output_prefix
+ */
+int set_output_names(option_t * options){
+    char work_dir[sizeof(DEFAULT_WORK_DIR)];
+
+    if(options->output_index != NULL_OPTION)
+        options->output_prefix = output_file_name(options->output_name, NULL);
+    else {
+        strcpy(work_dir, DEFAULT_WORK_DIR);
+        if(!mkdtemp(work_dir))          PRINT_AND_RETURN("mkdtemp failed in set_output_names",      OPEN_ERROR);
+        options->output_prefix = malloc(strlen(work_dir) + strlen(DEFAULT_OUTPUT_PREFIX) + 2);
+        if(options->output_prefix) sprintf(options->output_prefix, "%s/%s", work_dir, DEFAULT_OUTPUT_PREFIX);
+    }
+    if(!options->output_prefix)         PRINT_AND_RETURN("malloc failed in set_output_names",       MALLOC_ERROR);
+    return 0;
+}
+
+/* Helper function joining a prefix and a suffix with a dot
+ * Input    the prefix and the suffix, NULL to copy the prefix
+ * Output   the mallocated name, NULL on malloc failure
+ * Effect   calls malloc
+ */
+char * output_file_name(char * prefix, char * suffix){
+    char * name;
+
+    name = malloc(strlen(prefix) + (suffix ? strlen(suffix) + 1 : 0) + 1);
+    if(!name) return NULL;
+    if(suffix)  sprintf(name, "%s.%s", prefix, suffix);
+    else        strcpy(name, prefix);
+    return name;
+}
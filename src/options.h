@@ -5,43 +5,43 @@
 
 #define NULL_OPTION             -1
 
-#include <stdlib.h>
+// Default fraction of residues making a column a match column
+#define DEFAULT_SYMFRAC         0.0
 
-extern char DEFAULT_SINGLE_HMM_NAME             [];
-extern char DEFAULT_SYMFRAC                     [];
-extern char DEFAULT_HMM_MOLECULE                [];
+// Default number of nodes on each side of the alignment path scored by --score band
+#define DEFAULT_BAND            8
 
-extern char DEFAULT_TREE_OUTPUT                 [];
-extern char DEFAULT_TREE_MODEL                  [];
-extern char DEFAULT_TREE_MOLECULE               [];
-extern char DEFAULT_SUPPORT                     [];
+// Default number of requests sent by --client
+#define DEFAULT_NUM_REQUESTS    100
 
-extern char DEFAULT_DOUBLE_FIRST_HMM_NAME       [];
-extern char DEFAULT_DOUBLE_SECOND_HMM_NAME      [];
-extern char DEFAULT_DOUBLE_FIRST_MSA_NAME       [];
-extern char DEFAULT_DOUBLE_SECOND_MSA_NAME      [];
+// Default size in MB the cache of --cache is kept under
+#define DEFAULT_CACHE_SIZE      1024
 
-extern char DEFAULT_NOALI                       [];
-extern char DEFAULT_HEURISTICS_FILTER           [];
-extern char DEFAULT_E_VAL                       [];
+#include <stdlib.h>
+
+extern char DEFAULT_OUTPUT_PREFIX               [];
+extern char DEFAULT_WORK_DIR                    [];
 
-extern char DEFAULT_SINGLE_SEARCH_NAME          [];
-extern char DEFAULT_DOUBLE_FIRST_SEARCH_NAME    [];
-extern char DEFAULT_DOUBLE_SECOND_SEARCH_NAME   [];
+extern char SINGLE_HMM_SUFFIX                   [];
 
-extern char DEFAULT_SINGLE_SEARCH_FLAG          [];
-extern char DEFAULT_DOUBLE_FIRST_SEARCH_FLAG    [];
-extern char DEFAULT_DOUBLE_SECOND_SEARCH_FLAG   [];
+extern char TREE_OUTPUT_SUFFIX                  [];
+extern char DEFAULT_TREE_MODEL                  [];
+extern char DEFAULT_TREE_MOLECULE               [];
+extern char DEFAULT_SUPPORT                     [];
 
-extern char DEFAULT_HMMBUILD_OUT_SINGLE_NAME    [];
+extern char DOUBLE_FIRST_HMM_SUFFIX             [];
+extern char DOUBLE_SECOND_HMM_SUFFIX            [];
+extern char DOUBLE_FIRST_MSA_SUFFIX             [];
+extern char DOUBLE_SECOND_MSA_SUFFIX            [];
 
-extern char DEFAULT_HMMBUILD_OUT_SINGLE         [];
-extern char DEFAULT_HMMBUILD_OUT_FIRST_DOUBLE   [];
-extern char DEFAULT_HMMBUILD_OUT_SECOND_DOUBLE  [];
+extern char SINGLE_STATE_SUFFIX                 [];
+extern char DOUBLE_FIRST_STATE_SUFFIX           [];
+extern char DOUBLE_SECOND_STATE_SUFFIX          [];
+extern char SINGLE_SCORES_SUFFIX                [];
+extern char DOUBLE_FIRST_SCORES_SUFFIX          [];
+extern char DOUBLE_SECOND_SCORES_SUFFIX         [];
 
-extern char DEFAULT_HMMSEARCH_OUT_SINGLE         [];
-extern char DEFAULT_HMMSEARCH_OUT_FIRST_DOUBLE   [];
-extern char DEFAULT_HMMSEARCH_OUT_SECOND_DOUBLE  [];
+extern char DEFAULT_RESULTS_NAME                [];
 
 
 extern int DEFAULT_NUM_OPTIONS;
@@ -54,29 +54,63 @@ typedef struct options{
 
     int output_index;
    char * output_name;
+   char * output_prefix;    // prefix of the intermediate files once set_output_names is called
 
     int symfrac_index;
    char * symfrac;
+
+    int threads_index;
+    int num_threads;
+
+    int jobs_index;
+    int num_jobs;
+
+    int score_index;
+   char * score_mode;
+
+    int band_index;
+    int band;
+
+    int kernel_index;
+   char * kernel;
+
+    int keep_index;
+
+    int resume_index;
+
+    int batch_index;
+   char * batch_name;
+
+    int results_index;
+   char * results_name;
+
+    int serve_index;
+   char * serve_name;
+
+    int client_index;
+   char * client_name;
+
+    int requests_index;
+    int num_requests;
+
+    int cache_index;
+   char * cache_name;
+
+    int cache_size_index;
+    long cache_size;        // in MB
+
+    int profile_index;
+   char * profile_name;
+
+    int trace_index;
+   char * trace_name;
 } option_t;
 
 typedef struct hmm_options{
-   char * input_name;
-   char * symfrac;
+   float  symfrac;
    char * output_name;
-   char * molecule_name;
-   char * stdout;
 } hmmbuild_option_t;
 
-typedef struct hmm_options_2{
-   char * input_sequences_name;
-   char * input_hmm_name;
-   char * output_name; 
-   char * no_ali_option;
-   char * e_value_threshold;
-   char * heuristics_filtering_threshold;
-   char * stdout;
-} hmmsearch_options_t;
-
 typedef struct tree_options{
    char * input_name;
    char * output_name;
@@ -85,16 +119,6 @@ typedef struct tree_options{
    char * support;
 } fasttree_options_t;
 
-// Fields                                   
-extern hmmbuild_option_t        single_model_build_option;
-extern hmmbuild_option_t        double_model_first_build_option;
-extern hmmbuild_option_t        double_model_second_build_option;
-
-// Fields                                  
-extern hmmsearch_options_t  single_model_search_option;
-extern hmmsearch_options_t  double_model_fist_search_option;
-extern hmmsearch_options_t  double_model_second_search_option;
-
 // Fields                                 
 extern fasttree_options_t fasttree_options;
 
@@ -102,5 +126,7 @@ extern fasttree_options_t fasttree_options;
 extern int read_cmd_arg(int argc,char ** argv, option_t * options);
 extern int init_options(option_t * options);
 extern void destroy_options(option_t * options);
+extern int set_output_names(option_t * options);
+extern char * output_file_name(char * prefix, char * suffix);
 
 #endif
\ No newline at end of file
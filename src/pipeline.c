@@ -0,0 +1,503 @@
+// File in HMMDecompositionDecision, created by Thien Le in July 2018
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "pipeline.h"
+#include "msa.h"
+#include "tree.h"
+#include "utilities.h"
+#include "options.h"
+#include "tools.h"
+#include "sched.h"
+#include "hmm.h"
+#include "viterbi.h"
+#include "memfile.h"
+#include "hash.h"
+#include "checkpoint.h"
+#include "report.h"
+
+// Intermediate files of a family written when it has a prefix
+enum output_file {
+    SINGLE_HMM_FILE, DOUBLE_FIRST_HMM_FILE, DOUBLE_SECOND_HMM_FILE,
+    DOUBLE_FIRST_MSA_FILE, DOUBLE_SECOND_MSA_FILE, TREE_OUTPUT_FILE,
+    SINGLE_STATE_FILE, DOUBLE_FIRST_STATE_FILE, DOUBLE_SECOND_STATE_FILE,
+    SINGLE_SCORES_FILE, DOUBLE_FIRST_SCORES_FILE, DOUBLE_SECOND_SCORES_FILE,
+    NUM_OUTPUT_FILES
+};
+
+// Structures used by the FastTree job
+typedef struct tree_arg {
+    fasttree_options_t *    fasttree;   // input, output and settings of FastTree
+    cache_t *               cache;      // cache of the tree, NULL to always run FastTree
+    checkpoint_t *          checkpoint; // checkpoints of the run, NULL without a prefix
+    char *                  stage;      // name of the job in the checkpoints
+} tree_arg_t;
+
+// Structures used by the centroid decomposition job
+typedef struct split_arg {
+    msa_t *     msa;        // input msa
+    msa_t *     msa1;       // empty view receiving the side of the left subtree root
+    msa_t *     msa2;       // empty view receiving the other side
+    tree_t *    tree;       // initialized tree receiving the FastTree output
+    char *      tree_name;  // file FastTree writes the tree to
+    char *      msa1_name;  // files the sides are written to, NULL to keep them in memory only
+    char *      msa2_name;
+} split_arg_t;
+
+// Structures used by a model building job
+typedef struct build_arg {
+    msa_t *             msa;        // msa the model is built from
+    hmm_t *             hmm;        // initialized hmm receiving the model
+    hmmbuild_option_t   option;     // symfrac and the file the model is written to, NULL to keep it in memory only
+    cache_t *           cache;      // cache of the model, NULL to always build it
+    char                key[HASH_HEX_SIZE];     // key of the model in the cache, set by build_job
+    checkpoint_t *      checkpoint; // checkpoints of the run, NULL without a prefix
+    char *              stage;      // name of the job in the checkpoints
+    char *              state_name; // file the packed model is saved to for the checkpoints
+} build_arg_t;
+
+// Structures used by a scoring job
+typedef struct score_arg {
+    msa_t *     msa;            // sequences to score
+    hmm_t *     hmm;            // model they are scored against
+    float *     scores;         // bit score of every sequence of msa
+    int         num_threads;    // number of threads scoring the sequences
+    int         band;           // band around the alignment path (0 for the path alone), NULL_OPTION for the full Viterbi
+    int         check;          // whether to check that every kernel gives the same scores first
+    cache_t *   cache;          // cache of the scores, NULL to always compute them
+    char *      model_key;      // key of the model in the cache, set by its build job
+    checkpoint_t *  checkpoint; // checkpoints of the run, NULL without a prefix
+    char *      stage;          // name of the job in the checkpoints
+    char *      state_name;     // file the scores are saved to for the checkpoints
+} score_arg_t;
+
+// Private function templates
+int     tree_job                (void * arg);
+int     split_job               (void * arg);
+int     build_job               (void * arg);
+int     score_job               (void * arg);
+int     tree_key                (fasttree_options_t * fasttree, char * key);
+void    model_key               (msa_t * msa, float symfrac, char * key);
+void    scores_key              (char * model_key, int band, char * key);
+int     run_key                 (family_t * family, fasttree_options_t * fasttree, char * key);
+
+// Helper function that determines how many structures are completely allocated (as opposed to aborted by malloc failure) and free the allocation
+// It is private to this file, main has its own for the options
+static void clean_up(int allocated, char ** names, msa_t * msa, msa_t * msa1, msa_t * msa2, tree_t * tree, hmm_t * hmm, float * L, float * L1, float * L2, int tree_fd, checkpoint_t * checkpoint){
+    int i;
+
+    switch(allocated){
+        case 11:
+            destroy_checkpoint(checkpoint);
+        case 10:
+            if(tree_fd >= 0) close(tree_fd);
+        case 9:
+            free(L2);
+        case 8:
+            free(L1);
+        case 7:
+            free(L);
+        case 6:
+            destroy_hmm(&hmm[0]);
+            destroy_hmm(&hmm[1]);
+            destroy_hmm(&hmm[2]);
+        case 5:
+            destroy_msa(msa2);
+        case 4:
+            destroy_msa(msa1);
+        case 3:
+            destroy_tree(tree);
+        case 2:
+            destroy_msa(msa);
+        case 1:
+            for(i = 0; i < NUM_OUTPUT_FILES; i++) free(names[i]);
+        default:
+            return;
+    }
+}
+
+#define ALLOCATED_INFO allocated, names, &msa, &msa1, &msa2, &tree, hmm, L, L1, L2, tree_fd, &checkpoint
+
+/* Run the pipeline on one alignment: FastTree and the single model first, then the centroid decomposition of the tree,
+ * the hmms of both sides and the scores of every model, as a graph of jobs run num_jobs at a time. Every structure
+ * and file is owned by the call so families can be run from several threads at once
+ * Input:   the family, with its input name and settings
+ * Output:  0 on success, ERROR otherwise
+ * Effect:  calls malloc, runs FastTree, may write the intermediate files, set the results of the family
+ */
+int run_family(family_t * family){
+    static char * suffixes[NUM_OUTPUT_FILES] = {
+        SINGLE_HMM_SUFFIX, DOUBLE_FIRST_HMM_SUFFIX, DOUBLE_SECOND_HMM_SUFFIX,
+        DOUBLE_FIRST_MSA_SUFFIX, DOUBLE_SECOND_MSA_SUFFIX, TREE_OUTPUT_SUFFIX,
+        SINGLE_STATE_SUFFIX, DOUBLE_FIRST_STATE_SUFFIX, DOUBLE_SECOND_STATE_SUFFIX,
+        SINGLE_SCORES_SUFFIX, DOUBLE_FIRST_SCORES_SUFFIX, DOUBLE_SECOND_SCORES_SUFFIX
+    };
+    static char * stages[] = {
+        "single model hmm", "FastTree", "centroid decomposition", "double model 1st hmm", "double model 2nd hmm",
+        "single model scoring", "double model 1st scoring", "double model 2nd scoring"
+    };
+    char * names[NUM_OUTPUT_FILES];     // intermediate files, all NULL without a prefix
+    msa_t msa, msa1, msa2;      // msa struct for the single HMM and 2 msa structs for the double HMM
+    tree_t tree;                // FastTree output tree
+    int allocated;              // heap allocation counter (to prevent mem leak)
+    hmm_t hmm[3];               // hmm of the single model and the 2 hmms of the double model
+    fasttree_options_t fasttree;// FastTree run of this family
+    tree_arg_t fasttree_arg;    // structures used by the FastTree job
+    split_arg_t split;          // structures filled by the centroid decomposition job
+    build_arg_t build[3];       // structures used by the model building jobs
+    score_arg_t score[3];       // structures used by the scoring jobs
+    int score_threads;          // threads of each scoring job
+    sched_t sched;              // dependency graph of the jobs
+    int single_build, fasttree_run, decomposition, first_build, second_build, single_search, first_search, second_search;
+    int status, i;
+    float *L, *L1, *L2;         // array to bit score for the single HMM and 2 HMMs for the double HMM
+    int tree_fd;                // memory file holding the FastTree output, -1 if it is on disk
+    char tree_path[MEMFILE_PATH_SIZE];
+    checkpoint_t checkpoint;    // stages of the run complete on disk, only with a prefix
+    checkpoint_t * resume;      // &checkpoint with a prefix, NULL otherwise
+    char key[HASH_HEX_SIZE];
+    report_span_t span;         // stages run outside of the graph, measured when there is a report
+
+    L = NULL;
+    L1 = NULL;
+    L2 = NULL;
+    tree_fd = -1;
+    checkpoint.manifest_name = NULL;    // destroy_checkpoint does nothing on a run without a prefix
+    for(i = 0; i < NUM_OUTPUT_FILES; i++) names[i] = NULL;
+
+    allocated = 0;
+    if(!family)                                                     PRINT_AND_RETURN("family is NULL in run_family",            GENERAL_ERROR);
+    allocated = 1;
+    if(family->prefix)
+        for(i = 0; i < NUM_OUTPUT_FILES; i++)
+            if(!(names[i] = output_file_name(family->prefix, suffixes[i])))
+                                                                    PRINT_AND_EXIT("malloc failed for the names in run_family", MALLOC_ERROR, ALLOCATED_INFO);
+
+    begin_stage(&span, family->input_name, "parse input");
+    status = parse_input(&msa, family->input_name, family->num_threads);
+    end_stage(&span, status);
+    if(status                                   != SUCCESS)         PRINT_AND_EXIT("init msa failed in run_family",             GENERAL_ERROR, ALLOCATED_INFO);
+    allocated = 2;
+    family->num_seq = msa.num_seq;
+    family->length = msa.N;
+
+    // Structures filled by the centroid decomposition
+    if(init_tree(&tree)                         != SUCCESS)         PRINT_AND_EXIT("init tree failed in run_family",            GENERAL_ERROR, ALLOCATED_INFO);
+    allocated = 3;
+    if(make_smaller_msa(&msa, &msa1)            != SUCCESS)         PRINT_AND_EXIT("make small msa 1 failed in run_family",     GENERAL_ERROR, ALLOCATED_INFO);
+    allocated = 4;
+    if(make_smaller_msa(&msa, &msa2)            != SUCCESS)         PRINT_AND_EXIT("make small msa 2 failed in run_family",     GENERAL_ERROR, ALLOCATED_INFO);
+    allocated = 5;
+    if(init_hmm(&hmm[0]) != SUCCESS || init_hmm(&hmm[1]) != SUCCESS || init_hmm(&hmm[2]) != SUCCESS)
+                                                                    PRINT_AND_EXIT("init hmm failed in run_family",             GENERAL_ERROR, ALLOCATED_INFO);
+    allocated = 6;
+
+    // Scores of both models, the sides of the split are not larger than the input
+    L = malloc(msa.num_seq * sizeof(float));
+    if(!L)                                                          PRINT_AND_EXIT("malloc failed for L in run_family",         MALLOC_ERROR, ALLOCATED_INFO);
+    allocated = 7;
+    L1 = malloc(msa.num_seq * sizeof(float));
+    if(!L1)                                                         PRINT_AND_EXIT("malloc failed for L1 in run_family",        MALLOC_ERROR, ALLOCATED_INFO);
+    allocated = 8;
+    L2 = malloc(msa.num_seq * sizeof(float));
+    if(!L2)                                                         PRINT_AND_EXIT("malloc failed for L2 in run_family",        MALLOC_ERROR, ALLOCATED_INFO);
+    allocated = 9;
+
+    // Without a prefix, the hmms and the msa of the split are not written and the FastTree output stays in memory
+    fasttree = fasttree_options;
+    fasttree.input_name = family->input_name;
+    fasttree.output_name = names[TREE_OUTPUT_FILE];
+    if(!family->prefix){
+        tree_fd = open_memfile("fasttree.out", tree_path);
+        if(tree_fd < 0)                                             PRINT_AND_EXIT("open memfile failed in run_family",         OPEN_ERROR, ALLOCATED_INFO);
+        fasttree.output_name = tree_path;
+    }
+    allocated = 10;
+
+    // With a prefix, the manifest records every stage whose file is complete so a later run can skip it
+    resume = NULL;
+    if(family->prefix){
+        if(run_key(family, &fasttree, key)      != SUCCESS)         PRINT_AND_EXIT("run key failed in run_family",              GENERAL_ERROR, ALLOCATED_INFO);
+        if(init_checkpoint(&checkpoint, family->prefix, key, family->resume)
+                                                != SUCCESS)         PRINT_AND_EXIT("init checkpoint failed in run_family",      GENERAL_ERROR, ALLOCATED_INFO);
+        resume = &checkpoint;
+        if(checkpoint.resumed) printf("Resuming %s: %d stages complete\n", family->input_name, checkpoint.resumed);
+    }
+    allocated = 11;
+
+    // The three scoring jobs can run at the same time, up to num_jobs of them, and share the threads of the family
+    score_threads = family->num_threads;
+    if(family->num_jobs > 1) score_threads /= family->num_jobs < 3 ? family->num_jobs : 3;
+    if(score_threads < 1) score_threads = 1;
+
+    fasttree_arg = (tree_arg_t) { &fasttree, family->cache, resume, stages[1] };
+    split = (split_arg_t) { &msa, &msa1, &msa2, &tree, fasttree.output_name, names[DOUBLE_FIRST_MSA_FILE], names[DOUBLE_SECOND_MSA_FILE] };
+    build[0] = (build_arg_t) { &msa,    &hmm[0],    { family->symfrac, names[SINGLE_HMM_FILE] },        family->cache,  "", resume, stages[0],  names[SINGLE_STATE_FILE] };
+    build[1] = (build_arg_t) { &msa1,   &hmm[1],    { family->symfrac, names[DOUBLE_FIRST_HMM_FILE] },  family->cache,  "", resume, stages[3],  names[DOUBLE_FIRST_STATE_FILE] };
+    build[2] = (build_arg_t) { &msa2,   &hmm[2],    { family->symfrac, names[DOUBLE_SECOND_HMM_FILE] }, family->cache,  "", resume, stages[4],  names[DOUBLE_SECOND_STATE_FILE] };
+    score[0] = (score_arg_t) { &msa,    &hmm[0],    L,  score_threads,          family->band,   family->check,  family->cache,  build[0].key,
+                               resume,  stages[5],  names[SINGLE_SCORES_FILE] };
+    score[1] = (score_arg_t) { &msa1,   &hmm[1],    L1, score_threads,          family->band,   family->check,  family->cache,  build[1].key,
+                               resume,  stages[6],  names[DOUBLE_FIRST_SCORES_FILE] };
+    score[2] = (score_arg_t) { &msa2,   &hmm[2],    L2, score_threads,          family->band,   family->check,  family->cache,  build[2].key,
+                               resume,  stages[7],  names[DOUBLE_SECOND_SCORES_FILE] };
+
+    // The single model and the tree do not depend on each other, each double model only depends on the decomposition
+    // and each scoring only on its model, so the critical path is FastTree, decomposition, hmm building, scoring
+    if(init_sched(&sched)                       != SUCCESS)         PRINT_AND_EXIT("init sched failed in run_family",           GENERAL_ERROR, ALLOCATED_INFO);
+    sched.label = family->input_name;
+    single_build    = add_job(&sched, stages[0],    build_job,  &build[0]);
+    fasttree_run    = add_job(&sched, stages[1],    tree_job,   &fasttree_arg);
+    decomposition   = add_job(&sched, stages[2],    split_job,  &split);
+    first_build     = add_job(&sched, stages[3],    build_job,  &build[1]);
+    second_build    = add_job(&sched, stages[4],    build_job,  &build[2]);
+    single_search   = add_job(&sched, stages[5],    score_job,  &score[0]);
+    first_search    = add_job(&sched, stages[6],    score_job,  &score[1]);
+    second_search   = add_job(&sched, stages[7],    score_job,  &score[2]);
+    add_dependency(&sched, decomposition,   fasttree_run);
+    add_dependency(&sched, first_build,     decomposition);
+    add_dependency(&sched, second_build,    decomposition);
+    add_dependency(&sched, single_search,   single_build);
+    add_dependency(&sched, first_search,    first_build);
+    add_dependency(&sched, second_search,   second_build);
+
+    status = run_sched(&sched, family->num_jobs);
+    destroy_sched(&sched);
+    if(status                                   != SUCCESS)         PRINT_AND_EXIT("pipeline failed in run_family",             GENERAL_ERROR, ALLOCATED_INFO);
+
+    // Perform statistical test, currently, only BIC is used but can easily incorporate other tests
+    begin_stage(&span, family->input_name, "statistics");
+    status = bic(&msa, &msa1, &msa2, L, L1, L2, &hmm[0], &hmm[1], &hmm[2], &family->bic);
+    if(status == SUCCESS) status = aic(&msa, &msa1, &msa2, L, L1, L2, &hmm[0], &hmm[1], &hmm[2], &family->aic);
+    end_stage(&span, status);
+    if(status                                   != SUCCESS)         PRINT_AND_EXIT("problem with computing bic or aic in run_family",  GENERAL_ERROR, ALLOCATED_INFO);
+
+    clean_up(ALLOCATED_INFO);
+    return 0;
+}
+
+
+//INTERNAL FUNCTIONS IMPLEMENTATIONS
+
+// Run FastTree, unless the checkpoints or the cache hold the tree of the same input and settings
+int tree_job(void * arg){
+    tree_arg_t * tree = arg;
+    char key[HASH_HEX_SIZE];
+    int cached;
+
+    if(tree->checkpoint && checkpoint_done(tree->checkpoint, tree->stage, tree->fasttree->output_name) == SUCCESS)
+                                                                    return 0;
+    cached = 0;
+    if(tree->cache){
+        if(tree_key(tree->fasttree, key)        != SUCCESS)         PRINT_AND_RETURN("tree key failed in tree_job",             GENERAL_ERROR);
+        cached = cache_get_file(tree->cache, key, tree->fasttree->output_name) == SUCCESS;
+    }
+    if(!cached){
+        if(fasttree_job(tree->fasttree)         != SUCCESS)         PRINT_AND_RETURN("fasttree job failed in tree_job",         GENERAL_ERROR);
+        if(tree->cache) cache_put_file(tree->cache, key, tree->fasttree->output_name);
+    }
+    if(tree->checkpoint && checkpoint_record(tree->checkpoint, tree->stage, tree->fasttree->output_name)
+                                                != SUCCESS)         PRINT_AND_RETURN("checkpoint failed in tree_job",           GENERAL_ERROR);
+    return 0;
+}
+
+// Read the FastTree output, split it at the centroid edge and write the msa of both sides
+int split_job(void * arg){
+    split_arg_t * split = arg;
+    int left_root, right_root;  // endpoints of centroid decomposition
+    report_span_t phase;        // each step is a phase of the trace
+    int status;
+
+    begin_phase(&phase, "read_newick");
+    status = read_newick(split->tree, split->tree_name);
+    end_stage(&phase, status);
+    if(status                                   != SUCCESS)         PRINT_AND_RETURN("read newick failed in split_job",         GENERAL_ERROR);
+    begin_phase(&phase, "map_leaves_to_msa");
+    status = map_leaves_to_msa(split->tree, split->msa);
+    end_stage(&phase, status);
+    if(status                                   != SUCCESS)         PRINT_AND_RETURN("map leaves to msa failed in split_job",   GENERAL_ERROR);
+    begin_phase(&phase, "centroid_decomposition");
+    status = centroid_decomposition(split->tree, &left_root, &right_root);
+    end_stage(&phase, status);
+    if(status                                   != SUCCESS)         PRINT_AND_RETURN("centroid decomposition failed in split_job",  GENERAL_ERROR);
+    begin_phase(&phase, "retrieve_msa_from_root");
+    status = retrieve_msa_from_root(split->tree, split->msa1, split->msa2, split->msa);
+    end_stage(&phase, status);
+    if(status                                   != SUCCESS)         PRINT_AND_RETURN("retrieve_msa_from_root failed in split_job",  GENERAL_ERROR);
+
+    // Write MSA to a file in FASTA format
+    begin_phase(&phase, "write_msa");
+    status = SUCCESS;
+    if(split->msa1_name && write_msa(split->msa1, split->msa1_name) != SUCCESS) status = GENERAL_ERROR;
+    if(split->msa2_name && write_msa(split->msa2, split->msa2_name) != SUCCESS) status = GENERAL_ERROR;
+    end_stage(&phase, status);
+    if(status                                   != SUCCESS)         PRINT_AND_RETURN("write msa failed in split_job",           GENERAL_ERROR);
+    return 0;
+}
+
+// Build a profile HMM from an msa and write it to a file if it has one
+int build_job(void * arg){
+    build_arg_t * build = arg;
+    char * data;
+    size_t length;
+    int restored, cached, status;
+
+    // A model saved by a completed stage is used first, then a cached one, built from the same sequences and symfrac
+    restored = cached = 0;
+    if(build->checkpoint && checkpoint_done(build->checkpoint, build->stage, build->state_name) == SUCCESS
+    && read_whole_file(build->state_name, &data, &length) == SUCCESS){
+        restored = unpack_hmm(build->hmm, data, length) == SUCCESS;
+        free(data);
+    }
+    if(build->cache){
+        model_key(build->msa, build->option.symfrac, build->key);
+        if(!restored && cache_get(build->cache, build->key, &data, &length) == SUCCESS){
+            cached = unpack_hmm(build->hmm, data, length) == SUCCESS;
+            free(data);
+        }
+    }
+    if(!restored && !cached && build_hmm(build->hmm, build->msa, build->option.symfrac)
+                                                != SUCCESS)         PRINT_AND_RETURN("build hmm failed in build_job",           GENERAL_ERROR);
+    if(!restored && !cached && build->cache && pack_hmm(build->hmm, &data, &length) == SUCCESS){
+        cache_put(build->cache, build->key, data, length);
+        free(data);
+    }
+    if(build->option.output_name && write_hmm(build->hmm, build->option.output_name)
+                                                != SUCCESS)         PRINT_AND_RETURN("write hmm failed in build_job",           GENERAL_ERROR);
+
+    // The stage is complete once the packed model is on disk
+    if(!restored && build->checkpoint){
+        if(pack_hmm(build->hmm, &data, &length) != SUCCESS)         PRINT_AND_RETURN("pack hmm failed in build_job",            GENERAL_ERROR);
+        status = replace_file(build->state_name, data, length, 0);
+        free(data);
+        if(status != SUCCESS || checkpoint_record(build->checkpoint, build->stage, build->state_name) != SUCCESS)
+                                                                    PRINT_AND_RETURN("checkpoint failed in build_job",          GENERAL_ERROR);
+    }
+    return 0;
+}
+
+// Score every sequence of an msa against a model with the Viterbi algorithm, over all paths or near its alignment
+int score_job(void * arg){
+    score_arg_t * score = arg;
+    profile_t profile;
+    report_span_t phase;
+    char key[HASH_HEX_SIZE];
+    char * data;
+    size_t length;
+    int status;
+
+    // Scores saved by a completed stage are used first, then cached ones, the kernel self-test always scores
+    if(score->checkpoint && !score->check && checkpoint_done(score->checkpoint, score->stage, score->state_name) == SUCCESS
+    && read_whole_file(score->state_name, &data, &length) == SUCCESS){
+        status = length == score->msa->num_seq * sizeof(float);
+        if(status) memcpy(score->scores, data, length);
+        free(data);
+        if(status) return 0;
+    }
+
+    // Scores are cached under their model and the band
+    status = CACHE_MISS;
+    if(score->cache && !score->check){
+        scores_key(score->model_key, score->band, key);
+        if(cache_get(score->cache, key, &data, &length) == SUCCESS){
+            status = length == score->msa->num_seq * sizeof(float) ? SUCCESS : CACHE_MISS;
+            if(status == SUCCESS) memcpy(score->scores, data, length);
+            free(data);
+        }
+    }
+
+    if(status != SUCCESS){
+        if(init_profile(&profile)               != SUCCESS)         PRINT_AND_RETURN("init profile failed in score_job",        GENERAL_ERROR);
+        begin_phase(&phase, "build_profile");
+        status = build_profile(&profile, score->hmm);
+        end_stage(&phase, status);
+        if(status                               != SUCCESS)         PRINT_AND_RETURN("build profile failed in score_job",       GENERAL_ERROR);
+        if(score->check && check_kernels(&profile, score->msa) != SUCCESS){
+            destroy_profile(&profile);
+            PRINT_AND_RETURN("kernel self-test failed in score_job", GENERAL_ERROR);
+        }
+        begin_phase(&phase, score->band == NULL_OPTION ? "score_msa" : "score_msa_aligned");
+        if(score->band == NULL_OPTION)
+            status = score_msa(&profile, score->msa, score->num_threads, score->scores);
+        else
+            status = score_msa_aligned(&profile, score->hmm, score->msa, score->band, score->num_threads, score->scores);
+        end_stage(&phase, status);
+        destroy_profile(&profile);
+        if(status                               != SUCCESS)         PRINT_AND_RETURN("score msa failed in score_job",           GENERAL_ERROR);
+        if(score->cache && !score->check) cache_put(score->cache, key, score->scores, score->msa->num_seq * sizeof(float));
+    }
+
+    // The stage is complete once the scores are on disk
+    if(score->checkpoint && (replace_file(score->state_name, score->scores, score->msa->num_seq * sizeof(float), 0) != SUCCESS
+    || checkpoint_record(score->checkpoint, score->stage, score->state_name) != SUCCESS))
+                                                                    PRINT_AND_RETURN("checkpoint failed in score_job",          GENERAL_ERROR);
+    return 0;
+}
+
+/* Keys of the cache: the hash of everything an artifact is computed from, with its kind first so different kinds of
+ * artifacts never share a key. The tree depends on the bytes of the input and the settings of FastTree, a model on
+ * its sequences in order and symfrac, the scores on their model (hence their sequences) and the band
+ * Input:   what the artifact is computed from and room for HASH_HEX_SIZE characters
+ * Output:  tree_key returns 0 on success, ERROR if the input cannot be read
+ * Effect:  set key
+ */
+int tree_key(fasttree_options_t * fasttree, char * key){
+    char input[HASH_HEX_SIZE];
+    hash_t hash;
+
+    if(hash_file(fasttree->input_name, input)   != SUCCESS)         PRINT_AND_RETURN("hash file failed in tree_key",            GENERAL_ERROR);
+    init_hash(&hash);
+    update_hash_string(&hash, "tree");
+    update_hash_string(&hash, fasttree->model_name);
+    update_hash_string(&hash, fasttree->molecule_name);
+    update_hash_string(&hash, fasttree->support);
+    update_hash_string(&hash, input);
+    final_hash(&hash, key);
+    return 0;
+}
+
+void model_key(msa_t * msa, float symfrac, char * key){
+    hash_t hash;
+    int i; //loop variable
+
+    init_hash(&hash);
+    update_hash_string(&hash, "hmm");
+    update_hash(&hash, &symfrac, sizeof(float));
+    update_hash(&hash, &msa->N, sizeof(int));
+    update_hash(&hash, &msa->num_seq, sizeof(int));
+    for(i = 0; i < msa->num_seq; i++) update_hash(&hash, msa_sequence(msa, i), msa->N);
+    final_hash(&hash, key);
+}
+
+void scores_key(char * model_key, int band, char * key){
+    hash_t hash;
+
+    init_hash(&hash);
+    update_hash_string(&hash, "scores");
+    update_hash_string(&hash, model_key);
+    update_hash(&hash, &band, sizeof(int));
+    final_hash(&hash, key);
+}
+
+/* Key of a run in its manifest: the bytes of the input and every setting the stages depend on, so a manifest is only
+ * used again by a run that would compute the same files
+ * Input:   the family, its FastTree run and room for HASH_HEX_SIZE characters
+ * Output:  0 on success, ERROR if the input cannot be read
+ * Effect:  set key
+ */
+int run_key(family_t * family, fasttree_options_t * fasttree, char * key){
+    char tree[HASH_HEX_SIZE];
+    hash_t hash;
+
+    if(tree_key(fasttree, tree)                 != SUCCESS)         PRINT_AND_RETURN("tree key failed in run_key",              GENERAL_ERROR);
+    init_hash(&hash);
+    update_hash_string(&hash, "run");
+    update_hash_string(&hash, tree);
+    update_hash(&hash, &family->symfrac, sizeof(float));
+    update_hash(&hash, &family->band, sizeof(int));
+    final_hash(&hash, key);
+    return 0;
+}
@@ -0,0 +1,31 @@
+// File in HMMDecompositionDecision, created by Thien Le in July 2018
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include "stat.h"
+#include "cache.h"
+
+// One input alignment taken through the whole pipeline: FastTree, centroid decomposition, the 3 hmms and their scores
+typedef struct family {
+    char *      input_name;     // fasta file of the alignment
+    char *      prefix;         // prefix of the intermediate files, NULL to keep them in memory
+    float       symfrac;        // fraction of residues making a column a match column
+    int         band;           // band around the alignment path of score_msa_aligned, NULL_OPTION for the full Viterbi
+    int         check;          // whether to run the kernel self-test before scoring
+    int         num_threads;    // threads reading the input, shared by the scoring jobs running at the same time
+    int         num_jobs;       // jobs of the pipeline run at the same time
+    cache_t*    cache;          // cache of the tree, the hmms and the scores, NULL to compute them every time
+    int         resume;         // whether to skip the stages a previous run with the same prefix completed
+
+    // Filled by run_family
+    int         num_seq;        // number of sequences of the alignment
+    int         length;         // number of columns of the alignment
+    criterion_t bic;            // decision of both criteria
+    criterion_t aic;
+} family_t;
+
+// Run the pipeline on one alignment, safe to call from several threads at once on different families
+extern int run_family(family_t * family);
+
+#endif
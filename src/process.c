@@ -0,0 +1,210 @@
+// File in HMMDecompositionDecision, created by Thien Le in July 2018
+
+#define _GNU_SOURCE     // pipe2 and wait4
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "process.h"
+#include "utilities.h"
+#include "report.h"
+
+// Bytes read from a pipe at a time
+#define PIPE_CHUNK_SIZE         4096
+
+extern char ** environ;
+
+// Private function templates
+int     read_pipe               (int * fd, char ** buffer, size_t * length, size_t * capacity);
+void    close_fd                (int * fd);
+
+/* Constructor for the process, nothing runs until start_process is called
+ * Input:   pointer to the process
+ * Output:  0 on success, ERROR otherwise
+ * Effect:  set fields in the process
+ */
+int init_process(process_t * process){
+    if(!process)    PRINT_AND_RETURN("process is NULL in init_process",     GENERAL_ERROR);
+
+    process->pid        = 0;
+    process->out_fd     = -1;
+    process->err_fd     = -1;
+    process->out        = NULL;
+    process->out_length = 0;
+    process->err        = NULL;
+    process->err_length = 0;
+    process->status     = 0;
+    memset(&process->usage, 0, sizeof(struct rusage));
+    process->name[0] = 0;
+    return 0;
+}
+
+/* Destructor for the process that frees all mallocated fields and closes the pipes
+ * A child still running is killed and waited for so it does not outlive the process
+ * Input:   pointer to the process
+ * Output:  nothing
+ * Effect:  freeing mallocated blocks, closing file descriptors, may kill the child
+ */
+void destroy_process(process_t * process){
+    if(!process) return;
+
+    close_fd(&process->out_fd);
+    close_fd(&process->err_fd);
+    if(process->pid > 0){
+        kill(process->pid, SIGKILL);
+        while(waitpid(process->pid, NULL, 0) < 0 && errno == EINTR);
+    }
+    free(process->out);
+    free(process->err);
+    init_process(process);
+}
+
+/* Start a child with posix_spawnp (vfork and exec, no shell): argv is passed as is, stderr always goes to a pipe and stdout
+ * to a pipe or to a file truncated first. Both read ends are close-on-exec so children started by other threads at the same
+ * time do not hold them open
+ * Input:   an initialized process, the NULL terminated arguments (argv[0] is searched in PATH) and the stdout file or NULL
+ * Output:  0 on success, ERROR otherwise
+ * Effect:  open pipes, start a child
+ */
+int start_process(process_t * process, char ** argv, char * output_name){
+    posix_spawn_file_actions_t actions;
+    int out_pipe[2] = { -1, -1 };
+    int err_pipe[2] = { -1, -1 };
+    int status;
+
+    if(!process)                    PRINT_AND_RETURN("process is NULL in start_process",            GENERAL_ERROR);
+    if(!argv || !argv[0])           PRINT_AND_RETURN("argv is empty in start_process",              GENERAL_ERROR);
+    if(process->pid)                PRINT_AND_RETURN("process already started in start_process",    GENERAL_ERROR);
+
+    if(pipe2(err_pipe, O_CLOEXEC) != 0 || (!output_name && pipe2(out_pipe, O_CLOEXEC) != 0)){
+        close_fd(&err_pipe[0]);
+        close_fd(&err_pipe[1]);
+        PRINT_AND_RETURN("pipe failed in start_process",                                            OPEN_ERROR);
+    }
+
+    snprintf(process->name, PROCESS_NAME_SIZE, "%s", argv[0]);
+    clock_gettime(CLOCK_MONOTONIC, &process->started);
+    posix_spawn_file_actions_init(&actions);
+    if(output_name) posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, output_name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    else            posix_spawn_file_actions_adddup2(&actions, out_pipe[1], STDOUT_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, err_pipe[1], STDERR_FILENO);
+    status = posix_spawnp(&process->pid, argv[0], &actions, NULL, argv, environ);
+    posix_spawn_file_actions_destroy(&actions);
+
+    // Only the child writes to the pipes
+    close_fd(&out_pipe[1]);
+    close_fd(&err_pipe[1]);
+    if(status != 0){
+        close_fd(&out_pipe[0]);
+        close_fd(&err_pipe[0]);
+        process->pid = 0;
+        fprintf(stderr, "%s: %s\n", argv[0], strerror(status));
+        PRINT_AND_RETURN("posix_spawnp failed in start_process",                                    GENERAL_ERROR);
+    }
+    process->out_fd = out_pipe[0];
+    process->err_fd = err_pipe[0];
+    return 0;
+}
+
+/* Read stdout and stderr of a started child until both are closed, then reap it with wait4
+ * Both pipes are polled together so a child filling one of them while the other is read never blocks
+ * Input:   a started process
+ * Output:  0 if the child exited with status 0, ERROR otherwise
+ * Effect:  calls malloc, set out, err, status and usage, close the pipes, add the child to the report if there is one
+ */
+int wait_process(process_t * process){
+    struct pollfd fds[2];
+    size_t out_capacity, err_capacity;
+    int piped, num_fds, i, failed;
+
+    if(!process)                    PRINT_AND_RETURN("process is NULL in wait_process",             GENERAL_ERROR);
+    if(process->pid <= 0)           PRINT_AND_RETURN("process not started in wait_process",         GENERAL_ERROR);
+
+    piped = process->out_fd >= 0;
+    out_capacity = err_capacity = 0;
+    failed = 0;
+    while(process->out_fd >= 0 || process->err_fd >= 0){
+        num_fds = 0;
+        if(process->out_fd >= 0) fds[num_fds++] = (struct pollfd) { process->out_fd, POLLIN, 0 };
+        if(process->err_fd >= 0) fds[num_fds++] = (struct pollfd) { process->err_fd, POLLIN, 0 };
+        if(poll(fds, num_fds, -1) < 0){
+            if(errno == EINTR) continue;
+            close_fd(&process->out_fd);
+            close_fd(&process->err_fd);
+            failed = 1;
+            break;
+        }
+
+        for(i = 0; i < num_fds; i++){
+            if(!fds[i].revents) continue;
+            if(fds[i].fd == process->out_fd)
+                failed |= read_pipe(&process->out_fd, &process->out, &process->out_length, &out_capacity) != SUCCESS;
+            else
+                failed |= read_pipe(&process->err_fd, &process->err, &process->err_length, &err_capacity) != SUCCESS;
+        }
+    }
+
+    // A child that wrote nothing still has empty outputs
+    if(!process->err)           process->err = calloc(1, 1);
+    if(piped && !process->out)  process->out = calloc(1, 1);
+
+    while(wait4(process->pid, &process->status, 0, &process->usage) < 0)
+        if(errno != EINTR){
+            failed = 1;
+            break;
+        }
+    if(!failed) report_process(process->name, process->pid, &process->started, &process->usage, process->status);
+    process->pid = 0;
+
+    if(failed)                      PRINT_AND_RETURN("reading the child failed in wait_process",    GENERAL_ERROR);
+    if(!WIFEXITED(process->status) || WEXITSTATUS(process->status) != 0)
+                                    PRINT_AND_RETURN("child process failed in wait_process",        GENERAL_ERROR);
+    return 0;
+}
+
+
+//INTERNAL FUNCTIONS IMPLEMENTATIONS
+
+/* Append what a pipe holds to a growing buffer, the pipe is closed at end of file
+ * If the buffer cannot grow the data is dropped but the pipe is still read so the child does not block
+ * Input:   the read end, the buffer, its length and its capacity
+ * Output:  0 on success, ERROR if the data had to be dropped
+ * Effect:  calls realloc, may close the pipe
+ */
+int read_pipe(int * fd, char ** buffer, size_t * length, size_t * capacity){
+    char chunk[PIPE_CHUNK_SIZE];
+    char * grown;
+    ssize_t n;
+
+    n = read(*fd, chunk, PIPE_CHUNK_SIZE);
+    if(n < 0 && (errno == EINTR || errno == EAGAIN)) return 0;
+    if(n <= 0){
+        close_fd(fd);
+        return 0;
+    }
+
+    if(*length + n + 1 > *capacity){
+        grown = realloc(*buffer, 2 * (*length + n + 1));
+        if(!grown)  PRINT_AND_RETURN("realloc failed in read_pipe",     MALLOC_ERROR);
+        *buffer = grown;
+        *capacity = 2 * (*length + n + 1);
+    }
+    memcpy(*buffer + *length, chunk, n);
+    *length += n;
+    (*buffer)[*length] = 0;
+    return 0;
+}
+
+// Close a file descriptor if it is open and mark it closed
+void close_fd(int * fd){
+    if(*fd >= 0) close(*fd);
+    *fd = -1;
+}
@@ -0,0 +1,41 @@
+// File in HMMDecompositionDecision, created by Thien Le in July 2018
+
+#ifndef PROCESS_H
+#define PROCESS_H
+
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <time.h>
+
+// Longest program name kept for the reports
+#define PROCESS_NAME_SIZE       64
+
+// Child process started without a shell, its output is read through pipes
+typedef struct process {
+    pid_t           pid;            // process id, 0 once waited for
+    int             out_fd;         // read end of the stdout pipe, -1 if stdout goes to a file
+    int             err_fd;         // read end of the stderr pipe
+    char*           out;            // stdout of the child once waited for, null terminated (NULL if it goes to a file)
+    size_t          out_length;
+    char*           err;            // stderr of the child once waited for, null terminated
+    size_t          err_length;
+    int             status;         // wait status
+    struct rusage   usage;          // resources used by the child
+    char            name[PROCESS_NAME_SIZE];    // program of the child
+    struct timespec started;        // when the child was started
+} process_t;
+
+// Constructor & destructor
+extern int init_process(process_t * process);
+extern void destroy_process(process_t * process);
+
+// Start argv[0] (searched in PATH) with the arguments of argv (NULL terminated), stdout goes to output_name
+// or to a pipe if it is NULL. Returns as soon as the child is started
+extern int start_process(process_t * process, char ** argv, char * output_name);
+
+// Read the output of a started child until it exits, then collect its status and resource usage
+// Returns SUCCESS only if the child exited with status 0
+extern int wait_process(process_t * process);
+
+#endif
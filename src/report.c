@@ -0,0 +1,306 @@
+// File in HMMDecompositionDecision, created by Thien Le in July 2018
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+
+#include "report.h"
+#include "utilities.h"
+
+// Report of the run, set by main
+report_t * active_report = NULL;
+
+// Stage the calling thread is running, the stage child processes are attributed to
+static __thread report_span_t * current_span = NULL;
+
+// Private function templates
+void    begin_span              (report_span_t * span, int kind, char * input, char * stage);
+int     add_entry               (report_t * report, report_entry_t * entry);
+double  elapsed                 (struct timespec * from, struct timespec * to);
+double  cpu_seconds             (struct timeval * time);
+void    write_json_string       (FILE * f, char * string);
+void    write_entry             (FILE * f, report_entry_t * entry);
+void    write_event             (FILE * f, report_entry_t * entry, pid_t pid);
+
+/* Constructor for the report, the time of the entries counts from here
+ * Input:   pointer to the report
+ * Output:  0 on success, ERROR otherwise
+ * Effect:  set fields in the report, initialize its lock
+ */
+int init_report(report_t * report){
+    if(!report)                 PRINT_AND_RETURN("report is NULL in init_report",           GENERAL_ERROR);
+    if(pthread_mutex_init(&report->lock, NULL) != 0)
+                                PRINT_AND_RETURN("cannot create lock in init_report",       GENERAL_ERROR);
+    clock_gettime(CLOCK_MONOTONIC, &report->start);
+    report->num_entries = report->capacity = 0;
+    report->entries = NULL;
+    return 0;
+}
+
+/* Destructor for the report
+ * Input:   pointer to the report
+ * Output:  nothing
+ * Effect:  freeing mallocated blocks, destroy the lock
+ */
+void destroy_report(report_t * report){
+    if(!report) return;
+    free(report->entries);
+    report->entries = NULL;
+    report->num_entries = report->capacity = 0;
+    pthread_mutex_destroy(&report->lock);
+}
+
+/* Start measuring a stage on the calling thread. Nothing is measured without an active report
+ * Input:   the span, the alignment (NULL outside of a family) and the name of the stage, both kept until end_stage
+ * Output:  nothing
+ * Effect:  set fields in the span, the span becomes the stage of the thread
+ */
+void begin_stage(report_span_t * span, char * input, char * stage){
+    if(!active_report) return;
+    begin_span(span, REPORT_STAGE, input, stage);
+}
+
+// Start measuring a phase of the stage the calling thread is running, see begin_stage
+void begin_phase(report_span_t * span, char * phase){
+    if(!active_report) return;
+    begin_span(span, REPORT_PHASE, current_span ? current_span->input : NULL, phase);
+}
+
+/* Stop measuring a stage or phase and add it to the report
+ * Input:   the span given to begin_stage or begin_phase and the status of the stage
+ * Output:  nothing
+ * Effect:  add an entry to the report, the stage the thread ran before becomes its stage again
+ */
+void end_stage(report_span_t * span, int status){
+    report_entry_t entry;
+    struct timespec end, thread_cpu, process_cpu;
+    struct rusage usage;
+
+    if(!active_report) return;
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &thread_cpu);
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &process_cpu);
+    getrusage(RUSAGE_SELF, &usage);
+    current_span = span->parent;
+
+    memset(&entry, 0, sizeof(report_entry_t));
+    entry.kind = span->kind;
+    snprintf(entry.input, REPORT_NAME_SIZE, "%s", span->input ? span->input : "");
+    snprintf(entry.stage, REPORT_NAME_SIZE, "%s", span->stage);
+    entry.tid           = span->tid;
+    entry.start         = elapsed(&active_report->start, &span->start);
+    entry.wall          = elapsed(&span->start, &end);
+    entry.cpu           = elapsed(&span->thread_cpu, &thread_cpu);
+    entry.process_cpu   = elapsed(&span->process_cpu, &process_cpu);
+    entry.max_rss       = usage.ru_maxrss;
+    entry.status        = status;
+    add_entry(active_report, &entry);
+}
+
+/* Record a child process, under the stage the calling thread is running
+ * Input:   the program, its process id, when it was started, its usage and its wait status
+ * Output:  nothing
+ * Effect:  add an entry to the report
+ */
+void report_process(char * program, pid_t pid, struct timespec * start, struct rusage * usage, int status){
+    report_entry_t entry;
+    struct timespec end;
+
+    if(!active_report) return;
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    memset(&entry, 0, sizeof(report_entry_t));
+    entry.kind = REPORT_PROCESS;
+    snprintf(entry.input, REPORT_NAME_SIZE, "%s", current_span && current_span->input ? current_span->input : "");
+    snprintf(entry.stage, REPORT_NAME_SIZE, "%s", current_span ? current_span->stage : "");
+    snprintf(entry.program, REPORT_NAME_SIZE, "%s", program);
+    entry.pid       = pid;
+    entry.tid       = pid;
+    entry.start     = elapsed(&active_report->start, start);
+    entry.wall      = elapsed(start, &end);
+    entry.user      = cpu_seconds(&usage->ru_utime);
+    entry.sys       = cpu_seconds(&usage->ru_stime);
+    entry.max_rss   = usage->ru_maxrss;
+    entry.status    = WIFEXITED(status) ? WEXITSTATUS(status) : -WTERMSIG(status);
+    add_entry(active_report, &entry);
+}
+
+/* Write the report as one JSON object: the wall time of the run, the cpu time and peak resident set of the program
+ * and of its children, then the stages and the child processes in the order they ended. Times are in seconds,
+ * sizes in kB
+ * Input:   the report and the file to write
+ * Output:  0 on success, ERROR otherwise
+ * Effect:  write the file
+ */
+int write_report(report_t * report, char * filename){
+    struct rusage self, children;
+    struct timespec end;
+    FILE * f;
+    int kind, first;
+    int i; //loop variable
+
+    if(!report)                 PRINT_AND_RETURN("report is NULL in write_report",          GENERAL_ERROR);
+    f = fopen(filename, "w");
+    if(!f)                      PRINT_AND_RETURN("cannot open file in write_report",        OPEN_ERROR);
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    getrusage(RUSAGE_SELF, &self);
+    getrusage(RUSAGE_CHILDREN, &children);
+    pthread_mutex_lock(&report->lock);
+    fprintf(f, "{\n  \"wall\": %.6f,\n", elapsed(&report->start, &end));
+    fprintf(f, "  \"user\": %.6f, \"sys\": %.6f, \"max_rss_kb\": %ld,\n",
+            cpu_seconds(&self.ru_utime), cpu_seconds(&self.ru_stime), self.ru_maxrss);
+    fprintf(f, "  \"children\": { \"user\": %.6f, \"sys\": %.6f, \"max_rss_kb\": %ld },\n",
+            cpu_seconds(&children.ru_utime), cpu_seconds(&children.ru_stime), children.ru_maxrss);
+    for(kind = REPORT_STAGE; kind <= REPORT_PROCESS; kind++){
+        fprintf(f, "  \"%s\": [", kind == REPORT_STAGE ? "stages" : "processes");
+        first = 1;
+        for(i = 0; i < report->num_entries; i++){
+            if(report->entries[i].kind != kind) continue;
+            fprintf(f, first ? "\n    " : ",\n    ");
+            write_entry(f, &report->entries[i]);
+            first = 0;
+        }
+        fprintf(f, kind == REPORT_STAGE ? "\n  ],\n" : "\n  ]\n");
+    }
+    fprintf(f, "}\n");
+    pthread_mutex_unlock(&report->lock);
+
+    if(fclose(f) != 0)          PRINT_AND_RETURN("cannot write file in write_report",       OPEN_ERROR);
+    return 0;
+}
+
+/* Write the report in the JSON object format of Chrome trace events: one complete event per stage, phase and child
+ * process, stages and phases under the process and thread that ran them, nested by time, and each child under its own
+ * process id, named after the program and the stage that started it. Times are in microseconds from the start
+ * Input:   the report and the file to write
+ * Output:  0 on success, ERROR otherwise
+ * Effect:  write the file
+ */
+int write_trace(report_t * report, char * filename){
+    FILE * f;
+    pid_t pid;
+    int i; //loop variable
+
+    if(!report)                 PRINT_AND_RETURN("report is NULL in write_trace",           GENERAL_ERROR);
+    f = fopen(filename, "w");
+    if(!f)                      PRINT_AND_RETURN("cannot open file in write_trace",         OPEN_ERROR);
+
+    pid = getpid();
+    pthread_mutex_lock(&report->lock);
+    fprintf(f, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    fprintf(f, "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": %d, \"tid\": %d, \"args\": {\"name\": \"decide\"}}",
+            (int) pid, (int) pid);
+    for(i = 0; i < report->num_entries; i++){
+        fprintf(f, ",\n");
+        write_event(f, &report->entries[i], pid);
+    }
+    fprintf(f, "\n]}\n");
+    pthread_mutex_unlock(&report->lock);
+
+    if(fclose(f) != 0)          PRINT_AND_RETURN("cannot write file in write_trace",        OPEN_ERROR);
+    return 0;
+}
+
+
+//INTERNAL FUNCTIONS IMPLEMENTATIONS
+
+// Start a stage or phase, it becomes the one the thread is running
+void begin_span(report_span_t * span, int kind, char * input, char * stage){
+    span->kind = kind;
+    span->input = input;
+    span->stage = stage;
+    span->tid = syscall(SYS_gettid);
+    span->parent = current_span;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &span->thread_cpu);
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &span->process_cpu);
+    clock_gettime(CLOCK_MONOTONIC, &span->start);
+    current_span = span;
+}
+
+// Append an entry, doubling the room for them when full. An entry that does not fit is dropped
+int add_entry(report_t * report, report_entry_t * entry){
+    report_entry_t * grown;
+
+    pthread_mutex_lock(&report->lock);
+    if(report->num_entries == report->capacity){
+        grown = realloc(report->entries, (report->capacity ? 2 * report->capacity : 64) * sizeof(report_entry_t));
+        if(!grown){
+            pthread_mutex_unlock(&report->lock);
+            PRINT_AND_RETURN("realloc failed in add_entry",                                 MALLOC_ERROR);
+        }
+        report->entries = grown;
+        report->capacity = report->capacity ? 2 * report->capacity : 64;
+    }
+    report->entries[report->num_entries++] = *entry;
+    pthread_mutex_unlock(&report->lock);
+    return 0;
+}
+
+// Seconds between two times of the same clock
+double elapsed(struct timespec * from, struct timespec * to){
+    return (to->tv_sec - from->tv_sec) + (to->tv_nsec - from->tv_nsec) * 1e-9;
+}
+
+double cpu_seconds(struct timeval * time){
+    return time->tv_sec + time->tv_usec * 1e-6;
+}
+
+// Write a string between quotes, escaping quotes, backslashes and control characters
+void write_json_string(FILE * f, char * string){
+    fputc('"', f);
+    for(; *string; string++){
+        if(*string == '"' || *string == '\\')   fprintf(f, "\\%c", *string);
+        else if((unsigned char) *string < 0x20) fprintf(f, "\\u%04x", (unsigned char) *string);
+        else                                    fputc(*string, f);
+    }
+    fputc('"', f);
+}
+
+// Write one entry as a JSON object on one line
+void write_entry(FILE * f, report_entry_t * entry){
+    fprintf(f, "{ \"input\": ");
+    write_json_string(f, entry->input);
+    fprintf(f, ", \"stage\": ");
+    write_json_string(f, entry->stage);
+    if(entry->kind == REPORT_PROCESS){
+        fprintf(f, ", \"program\": ");
+        write_json_string(f, entry->program);
+        fprintf(f, ", \"pid\": %d", (int) entry->pid);
+    }
+    fprintf(f, ", \"start\": %.6f, \"wall\": %.6f", entry->start, entry->wall);
+    if(entry->kind == REPORT_STAGE)
+        fprintf(f, ", \"cpu\": %.6f, \"process_cpu\": %.6f", entry->cpu, entry->process_cpu);
+    else
+        fprintf(f, ", \"user\": %.6f, \"sys\": %.6f", entry->user, entry->sys);
+    fprintf(f, ", \"max_rss_kb\": %ld, \"status\": %d }", entry->max_rss, entry->status);
+}
+
+// Write one entry as a complete trace event, a child process is preceded by the event naming its process
+void write_event(FILE * f, report_entry_t * entry, pid_t pid){
+    char name[2 * REPORT_NAME_SIZE + 4];
+
+    if(entry->kind == REPORT_PROCESS){
+        snprintf(name, sizeof(name), "%s (%s)", entry->program, entry->stage);
+        fprintf(f, "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": %d, \"tid\": %d, \"args\": {\"name\": ",
+                (int) entry->pid, (int) entry->tid);
+        write_json_string(f, name);
+        fprintf(f, "}},\n");
+        pid = entry->pid;
+    }
+    fprintf(f, "{\"name\": ");
+    write_json_string(f, entry->kind == REPORT_PROCESS ? entry->program : entry->stage);
+    fprintf(f, ", \"cat\": \"%s\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, \"pid\": %d, \"tid\": %d, \"args\": {\"input\": ",
+            entry->kind == REPORT_STAGE ? "stage" : entry->kind == REPORT_PHASE ? "phase" : "process",
+            entry->start * 1e6, entry->wall * 1e6, (int) pid, (int) entry->tid);
+    write_json_string(f, entry->input);
+    if(entry->kind == REPORT_PROCESS)
+        fprintf(f, ", \"user\": %.6f, \"sys\": %.6f", entry->user, entry->sys);
+    else
+        fprintf(f, ", \"cpu\": %.6f", entry->cpu);
+    fprintf(f, ", \"max_rss_kb\": %ld, \"status\": %d}}", entry->max_rss, entry->status);
+}
@@ -0,0 +1,80 @@
+// File in HMMDecompositionDecision, created by Thien Le in July 2018
+
+#ifndef REPORT_H
+#define REPORT_H
+
+#include <pthread.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+// Longest alignment, stage or program name kept in an entry
+#define REPORT_NAME_SIZE        256
+
+// Kinds of entries, phases are the steps of a stage only shown in the trace
+enum report_kind { REPORT_STAGE, REPORT_PROCESS, REPORT_PHASE };
+
+// One stage or phase run by a thread of the program, or one child process it waited for
+typedef struct report_entry {
+    int     kind;                       // REPORT_STAGE, REPORT_PROCESS or REPORT_PHASE
+    char    input[REPORT_NAME_SIZE];    // alignment of the stage, empty outside of a family
+    char    stage[REPORT_NAME_SIZE];    // the stage or phase, or the stage that started the child
+    char    program[REPORT_NAME_SIZE];  // program of the child, empty for a stage
+    pid_t   pid;                        // process id of the child, 0 for a stage
+    pid_t   tid;                        // thread running the stage, process id of the child
+    double  start;                      // seconds since the report started
+    double  wall;                       // seconds from start to end
+    double  cpu;                        // cpu seconds of the thread running the stage
+    double  process_cpu;                // cpu seconds of the whole program during the stage, including the threads
+                                        // it started and any stage running at the same time
+    double  user;                       // cpu seconds of the child
+    double  sys;
+    long    max_rss;                    // peak resident set in kB of the program when the stage ended, or of the child
+    int     status;                     // SUCCESS or the error of the stage, exit status of the child (minus the signal killing it)
+} report_entry_t;
+
+// Time and resources of every stage and child process of a run, written as JSON at exit, as a report or as a trace
+typedef struct report {
+    struct timespec     start;          // when the report started
+    int                 num_entries;
+    int                 capacity;
+    report_entry_t*     entries;
+    pthread_mutex_t     lock;           // protects the entries
+} report_t;
+
+// A stage or phase being measured, from begin_stage or begin_phase to end_stage on the same thread. They can be nested
+typedef struct report_span {
+    int                 kind;           // REPORT_STAGE or REPORT_PHASE
+    char*               input;          // alignment of the stage, NULL outside of a family
+    char*               stage;          // name of the stage
+    pid_t               tid;            // thread running it
+    struct timespec     start;
+    struct timespec     thread_cpu;     // cpu clocks of the thread and of the program at begin_stage
+    struct timespec     process_cpu;
+    struct report_span* parent;         // stage the thread was running at begin_stage
+} report_span_t;
+
+// Report of the run, NULL unless --profile or --trace is given so measuring costs a test when it is off
+extern report_t * active_report;
+
+// Constructor & destructor
+extern int init_report(report_t * report);
+extern void destroy_report(report_t * report);
+
+// Measure a stage on the calling thread, child processes it waits for are attributed to it. A phase is a step of the
+// stage the thread is running, under the same alignment. end_stage ends both
+extern void begin_stage(report_span_t * span, char * input, char * stage);
+extern void begin_phase(report_span_t * span, char * phase);
+extern void end_stage(report_span_t * span, int status);
+
+// Record a child process waited for by the calling thread, its usage as given by wait4
+extern void report_process(char * program, pid_t pid, struct timespec * start, struct rusage * usage, int status);
+
+// Write the stages, child processes and totals of the program and its children as JSON
+extern int write_report(report_t * report, char * filename);
+
+// Write every entry as Chrome trace events (chrome://tracing, Perfetto)
+extern int write_trace(report_t * report, char * filename);
+
+#endif
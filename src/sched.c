@@ -0,0 +1,171 @@
+// File in HMMDecompositionDecision, created by Thien Le in July 2018
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "sched.h"
+#include "utilities.h"
+#include "report.h"
+
+// Private function templates
+void*   sched_worker            (void * arg);
+int     sched_done              (sched_t * sched);
+
+/* Constructor for the job graph
+ * Input:   pointer to the graph
+ * Output:  0 on success, ERROR otherwise
+ * Effect:  set fields in the graph, initialize its lock
+ */
+int init_sched(sched_t * sched){
+    if(!sched)          PRINT_AND_RETURN("sched is NULL in init_sched",         GENERAL_ERROR);
+
+    sched->num_jobs = 0;
+    sched->ready_head = sched->ready_tail = 0;
+    sched->running = sched->finished = sched->failed = 0;
+    sched->label = NULL;
+    if(pthread_mutex_init(&sched->lock, NULL) != 0)
+                        PRINT_AND_RETURN("cannot create lock in init_sched",    GENERAL_ERROR);
+    if(pthread_cond_init(&sched->changed, NULL) != 0){
+        pthread_mutex_destroy(&sched->lock);
+        PRINT_AND_RETURN("cannot create condition in init_sched",  GENERAL_ERROR);
+    }
+    return 0;
+}
+
+/* Destructor for the job graph. The graph must not be running
+ * Input:   pointer to the graph
+ * Output:  nothing
+ * Effect:  destroy the lock of the graph
+ */
+void destroy_sched(sched_t * sched){
+    if(!sched) return;
+    pthread_mutex_destroy(&sched->lock);
+    pthread_cond_destroy(&sched->changed);
+    sched->num_jobs = 0;
+}
+
+/* Add a job without prerequisites to the graph
+ * Input:   the graph, the name of the job, the function running it and its argument
+ * Output:  the index of the job in the graph, ERROR otherwise
+ * Effect:  set fields in the graph
+ */
+int add_job(sched_t * sched, char * name, sched_fn_t run, void * arg){
+    sched_job_t * job;
+
+    if(!sched)          PRINT_AND_RETURN("sched is NULL in add_job",            GENERAL_ERROR);
+    if(!run)            PRINT_AND_RETURN("run is NULL in add_job",              GENERAL_ERROR);
+    if(sched->num_jobs == SCHED_MAX_JOBS)
+                        PRINT_AND_RETURN("too many jobs in add_job",            GENERAL_ERROR);
+
+    job = &sched->jobs[sched->num_jobs];
+    job->name = name;
+    job->run = run;
+    job->arg = arg;
+    job->num_waiting = 0;
+    job->num_dependents = 0;
+    job->status = SUCCESS;
+    return sched->num_jobs++;
+}
+
+/* Make a job wait for another one to succeed before it starts
+ * Input:   the graph, the job and its prerequisite, both returned by add_job
+ * Output:  0 on success, ERROR otherwise
+ * Effect:  set fields in both jobs
+ */
+int add_dependency(sched_t * sched, int job, int prerequisite){
+    sched_job_t * before;
+
+    if(!sched)          PRINT_AND_RETURN("sched is NULL in add_dependency",     GENERAL_ERROR);
+    if(job < 0 || job >= sched->num_jobs || prerequisite < 0 || prerequisite >= sched->num_jobs)
+                        PRINT_AND_RETURN("job out of range in add_dependency",  GENERAL_ERROR);
+
+    before = &sched->jobs[prerequisite];
+    if(before->num_dependents == SCHED_MAX_DEPENDENTS)
+                        PRINT_AND_RETURN("too many dependents in add_dependency",   GENERAL_ERROR);
+    before->dependents[before->num_dependents++] = job;
+    sched->jobs[job].num_waiting++;
+    return 0;
+}
+
+/* Run the whole graph. The calling thread works as one of the num_slots threads
+ * Once a job fails the jobs already running are waited for and no other job is started
+ * Input:   the graph and the number of jobs that may run at the same time
+ * Output:  0 if every job succeeded, ERROR otherwise
+ * Effect:  the effects of the jobs, starts up to num_slots - 1 threads
+ */
+int run_sched(sched_t * sched, int num_slots){
+    pthread_t threads[SCHED_MAX_JOBS];
+    int num_threads;
+    int i; //loop variable
+
+    if(!sched)          PRINT_AND_RETURN("sched is NULL in run_sched",          GENERAL_ERROR);
+
+    // Queue the jobs without prerequisites
+    sched->ready_head = sched->ready_tail = 0;
+    sched->running = sched->finished = sched->failed = 0;
+    for(i = 0; i < sched->num_jobs; i++)
+        if(sched->jobs[i].num_waiting == 0) sched->ready[sched->ready_tail++] = i;
+
+    if(num_slots > sched->num_jobs) num_slots = sched->num_jobs;
+    for(num_threads = 0; num_threads < num_slots - 1; num_threads++)
+        if(pthread_create(&threads[num_threads], NULL, sched_worker, sched) != 0) break;
+    sched_worker(sched);
+    for(i = 0; i < num_threads; i++) pthread_join(threads[i], NULL);
+
+    if(sched->failed || sched->finished != sched->num_jobs)
+                        PRINT_AND_RETURN("some jobs did not complete in run_sched", GENERAL_ERROR);
+    return 0;
+}
+
+/* Loop of one thread of the pool: take a ready job, run it, queue the jobs that were only waiting on it
+ * Input:   the graph
+ * Output:  NULL
+ * Effect:  run jobs, set fields in the graph, add each job to the report if there is one
+ */
+void * sched_worker(void * arg){
+    sched_t * sched = arg;
+    sched_job_t * job;
+    report_span_t span;
+    int i; //loop variable
+
+    pthread_mutex_lock(&sched->lock);
+    while(!sched_done(sched)){
+        if(sched->ready_head == sched->ready_tail){
+            pthread_cond_wait(&sched->changed, &sched->lock);
+            continue;
+        }
+        job = &sched->jobs[sched->ready[sched->ready_head++]];
+        sched->running++;
+        printf("Running %s..\n", job->name);
+        pthread_mutex_unlock(&sched->lock);
+
+        begin_stage(&span, sched->label, job->name);
+        job->status = job->run(job->arg);
+        end_stage(&span, job->status);
+
+        pthread_mutex_lock(&sched->lock);
+        sched->running--;
+        sched->finished++;
+        if(job->status != SUCCESS){
+            printf("%s failed\n", job->name);
+            sched->failed = 1;
+        } else 
+            for(i = 0; i < job->num_dependents; i++)
+                if(--sched->jobs[job->dependents[i]].num_waiting == 0)
+                    sched->ready[sched->ready_tail++] = job->dependents[i];
+        pthread_cond_broadcast(&sched->changed);
+    }
+    pthread_mutex_unlock(&sched->lock);
+    return NULL;
+}
+
+/* Check whether the pool can stop: every job finished, a job failed, or nothing runs and nothing is ready (a cycle)
+ * Input:   the graph, with its lock held
+ * Output:  1 if the pool can stop, 0 otherwise
+ * Effect:  none
+ */
+int sched_done(sched_t * sched){
+    if(sched->failed || sched->finished == sched->num_jobs) return 1;
+    return sched->running == 0 && sched->ready_head == sched->ready_tail;
+}
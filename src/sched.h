@@ -0,0 +1,53 @@
+// File in HMMDecompositionDecision, created by Thien Le in July 2018
+
+#ifndef SCHED_H
+#define SCHED_H
+
+#include <pthread.h>
+
+// Largest number of jobs in one graph and of jobs waiting on one job
+#define SCHED_MAX_JOBS          64
+#define SCHED_MAX_DEPENDENTS    8
+
+// A job takes one argument and returns SUCCESS or an error value
+typedef int (*sched_fn_t)(void * arg);
+
+// One node of the job graph
+typedef struct sched_job {
+    char*       name;                               // name printed when the job starts or fails
+    sched_fn_t  run;                                // function running the job
+    void*       arg;                                // argument passed to run
+    int         num_waiting;                        // number of prerequisites not finished yet
+    int         num_dependents;                     // number of jobs waiting on this one
+    int         dependents[SCHED_MAX_DEPENDENTS];   // jobs waiting on this one
+    int         status;                             // return value of run
+} sched_job_t;
+
+// Dependency graph of jobs run by a pool of threads. A job is queued as soon as all its prerequisites succeeded
+// and is picked up by the first free thread, so at most as many jobs as threads run at the same time
+typedef struct sched {
+    int             num_jobs;               // number of jobs in the graph
+    sched_job_t     jobs[SCHED_MAX_JOBS];   // the jobs, in the order they were added
+    int             ready[SCHED_MAX_JOBS];  // queue of the jobs whose prerequisites are all done
+    int             ready_head;             // next job to run in ready
+    int             ready_tail;             // end of the queue in ready
+    int             running;                // number of jobs currently running
+    int             finished;               // number of jobs done
+    int             failed;                 // set once a job failed, no job is started after that
+    char*           label;                  // alignment the jobs are reported under, NULL if none
+    pthread_mutex_t lock;                   // protects every field above once the graph is running
+    pthread_cond_t  changed;                // signaled when a job is queued or the graph is done
+} sched_t;
+
+// Constructor & destructor
+extern int init_sched(sched_t * sched);
+extern void destroy_sched(sched_t * sched);
+
+// Building the graph
+extern int add_job(sched_t * sched, char * name, sched_fn_t run, void * arg);
+extern int add_dependency(sched_t * sched, int job, int prerequisite);
+
+// Run every job with at most num_slots of them at a time
+extern int run_sched(sched_t * sched, int num_slots);
+
+#endif
@@ -0,0 +1,437 @@
+// File in HMMDecompositionDecision, created by Thien Le in July 2018
+
+#define _GNU_SOURCE     // accept4
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+#include "server.h"
+#include "memfile.h"
+#include "utilities.h"
+
+// Bytes copied from a connection at a time
+#define SOCKET_CHUNK_SIZE       65536
+
+// Return value of read_line and copy_bytes when the client sent nothing for SERVER_TIMEOUT seconds
+#define TIMEOUT_ERROR           -4
+
+// State shared by the connections of the load generator
+typedef struct client {
+    char*           socket_name;    // path of the socket of the daemon
+    char*           payload;        // request sent every time: the FASTA line and the alignment
+    size_t          length;
+    int             num_requests;   // number of requests to send
+    int             next;           // next request to send
+    int             failed;         // number of requests that were not answered ok
+    double*         latency;        // time from connecting to the end of the answer of each request, in ms
+    char            answer[SERVER_ANSWER_SIZE];     // answer of the last request answered ok
+    pthread_mutex_t lock;           // protects next, failed and answer
+} client_t;
+
+// Private function templates
+int     set_address             (struct sockaddr_un * address, char * socket_name);
+int     send_all                (int fd, char * buffer, size_t length);
+int     read_line               (int fd, char * line, int size);
+int     copy_bytes              (int from, int to, long length);
+int     answer_request          (server_t * server, int fd);
+void*   server_worker           (void * arg);
+int     send_request            (client_t * client, char * answer);
+void*   client_worker           (void * arg);
+int     compare_latency         (const void * a, const void * b);
+double  elapsed_ms              (struct timespec * start);
+
+/* Constructor for the daemon: bind and listen on the socket. A socket file left by a daemon that did not stop is
+ * replaced, a socket a daemon still listens on is not
+ * Input:   pointer to the server, the path of the socket, the settings of every alignment and the number of threads
+ * Output:  0 on success, ERROR otherwise
+ * Effect:  set fields in the server, create the socket file, initialize its lock
+ */
+int init_server(server_t * server, char * socket_name, family_t * settings, int num_workers){
+    struct sockaddr_un address;
+    struct stat info;
+    int fd;
+
+    if(!server)                 PRINT_AND_RETURN("server is NULL in init_server",               GENERAL_ERROR);
+    if(!settings)               PRINT_AND_RETURN("settings is NULL in init_server",             GENERAL_ERROR);
+    server->listen_fd = -1;
+    if(set_address(&address, socket_name) != SUCCESS)
+                                PRINT_AND_RETURN("socket name too long in init_server",         GENERAL_ERROR);
+
+    if(stat(socket_name, &info) == 0){
+        if(!S_ISSOCK(info.st_mode))
+                                PRINT_AND_RETURN("socket name is not a socket in init_server",  GENERAL_ERROR);
+        fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if(fd >= 0 && connect(fd, (struct sockaddr *) &address, sizeof(address)) == 0){
+            close(fd);
+            PRINT_AND_RETURN("a daemon already listens on the socket in init_server",           GENERAL_ERROR);
+        }
+        if(fd >= 0) close(fd);
+        unlink(socket_name);
+    }
+
+    server->listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if(server->listen_fd < 0)   PRINT_AND_RETURN("socket failed in init_server",                OPEN_ERROR);
+    if(bind(server->listen_fd, (struct sockaddr *) &address, sizeof(address)) != 0 || listen(server->listen_fd, SOMAXCONN) != 0){
+        close(server->listen_fd);
+        server->listen_fd = -1;
+        PRINT_AND_RETURN("cannot listen on the socket in init_server",                          OPEN_ERROR);
+    }
+    if(pthread_mutex_init(&server->lock, NULL) != 0){
+        close(server->listen_fd);
+        unlink(socket_name);
+        server->listen_fd = -1;
+        PRINT_AND_RETURN("cannot create lock in init_server",                                   GENERAL_ERROR);
+    }
+
+    server->socket_name = socket_name;
+    server->settings = *settings;
+    server->settings.prefix = NULL;
+    server->num_workers = num_workers < 1 ? 1 : num_workers;
+    server->stopping = server->served = 0;
+    return 0;
+}
+
+/* Destructor for the daemon. It must not be running
+ * Input:   pointer to the server
+ * Output:  nothing
+ * Effect:  close the socket and remove its file, destroy the lock
+ */
+void destroy_server(server_t * server){
+    if(!server || server->listen_fd < 0) return;
+    close(server->listen_fd);
+    unlink(server->socket_name);
+    pthread_mutex_destroy(&server->lock);
+    server->listen_fd = -1;
+}
+
+/* Answer requests with num_workers threads started once, each one accepting a connection and running its alignment
+ * The kernels are picked and the threads are started once per process instead of once for every request, each request
+ * runs on the worker that accepted it and reuses the DP rows that worker kept from its previous requests
+ * Input:   an initialized server
+ * Output:  0 on success, ERROR otherwise
+ * Effect:  run the pipeline for every request, starts num_workers - 1 threads
+ */
+int run_server(server_t * server){
+    pthread_t * threads;
+    int num_threads;
+    int i; //loop variable
+
+    if(!server || server->listen_fd < 0)
+                                PRINT_AND_RETURN("server is not initialized in run_server",     GENERAL_ERROR);
+    threads = malloc(server->num_workers * sizeof(pthread_t));
+    if(!threads)                PRINT_AND_RETURN("malloc failed in run_server",                 MALLOC_ERROR);
+
+    for(num_threads = 0; num_threads < server->num_workers - 1; num_threads++)
+        if(pthread_create(&threads[num_threads], NULL, server_worker, server) != 0) break;
+    server_worker(server);
+    for(i = 0; i < num_threads; i++) pthread_join(threads[i], NULL);
+    free(threads);
+    return 0;
+}
+
+/* Load generator: send the same alignment num_requests times, num_connections requests at a time, and print the
+ * throughput and the latency percentiles (nearest rank) of the requests
+ * Input:   the socket of the daemon, the alignment, the number of requests and of connections at the same time
+ * Output:  0 if every request was answered ok, ERROR otherwise
+ * Effect:  calls malloc, starts up to num_connections - 1 threads, print the report
+ */
+int run_client(char * socket_name, char * input_name, int num_requests, int num_connections){
+    client_t client;
+    struct timespec start;
+    pthread_t * threads;
+    FILE * f;
+    long size;
+    int num_threads, header;
+    double total, seconds;
+    int i; //loop variable
+
+    if(!socket_name || !input_name)
+                                PRINT_AND_RETURN("socket or input name is NULL in run_client",  GENERAL_ERROR);
+
+    // Every request sends the whole file
+    f = fopen(input_name, "r");
+    if(!f)                      PRINT_AND_RETURN("cannot open input in run_client",             OPEN_ERROR);
+    fseek(f, 0, SEEK_END);
+    size = ftell(f);
+    rewind(f);
+    client.payload = malloc(size + 32);
+    client.latency = malloc(num_requests * sizeof(double));
+    threads = malloc(num_connections * sizeof(pthread_t));
+    if(!client.payload || !client.latency || !threads){
+        fclose(f);
+        free(client.payload);
+        free(client.latency);
+        free(threads);
+        PRINT_AND_RETURN("malloc failed in run_client",                                         MALLOC_ERROR);
+    }
+    header = sprintf(client.payload, "FASTA %ld\n", size);
+    client.length = header + fread(client.payload + header, 1, size, f);
+    fclose(f);
+
+    client.socket_name = socket_name;
+    client.num_requests = num_requests;
+    client.next = client.failed = 0;
+    strclr(client.answer);
+    pthread_mutex_init(&client.lock, NULL);
+
+    if(num_connections > num_requests) num_connections = num_requests;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(num_threads = 0; num_threads < num_connections - 1; num_threads++)
+        if(pthread_create(&threads[num_threads], NULL, client_worker, &client) != 0) break;
+    client_worker(&client);
+    for(i = 0; i < num_threads; i++) pthread_join(threads[i], NULL);
+    seconds = elapsed_ms(&start) / 1000;
+    pthread_mutex_destroy(&client.lock);
+
+    qsort(client.latency, num_requests, sizeof(double), compare_latency);
+    for(total = 0, i = 0; i < num_requests; i++) total += client.latency[i];
+    printf("%d requests over %d connections in %.3f s (%.2f requests/s), %d failed\n",
+           num_requests, num_threads + 1, seconds, num_requests / seconds, client.failed);
+    printf("Latency in ms: p50 %.2f, p99 %.2f, mean %.2f, max %.2f\n",
+           client.latency[(num_requests + 1) / 2 - 1], client.latency[(99 * num_requests + 99) / 100 - 1],
+           total / num_requests, client.latency[num_requests - 1]);
+    if(!strempty(client.answer)) printf("Answer: %s", client.answer);
+
+    free(client.payload);
+    free(client.latency);
+    free(threads);
+    if(client.failed)           PRINT_AND_RETURN("some requests failed in run_client",          GENERAL_ERROR);
+    return 0;
+}
+
+
+//INTERNAL FUNCTIONS IMPLEMENTATIONS
+
+// Fill the address of a socket, ERROR if the path does not fit
+int set_address(struct sockaddr_un * address, char * socket_name){
+    if(!socket_name || strlen(socket_name) >= sizeof(address->sun_path)) return GENERAL_ERROR;
+    memset(address, 0, sizeof(struct sockaddr_un));
+    address->sun_family = AF_UNIX;
+    strcpy(address->sun_path, socket_name);
+    return 0;
+}
+
+// Write a whole buffer to a socket, a peer that left does not raise SIGPIPE
+int send_all(int fd, char * buffer, size_t length){
+    ssize_t n;
+
+    while(length > 0){
+        n = send(fd, buffer, length, MSG_NOSIGNAL);
+        if(n < 0 && errno == EINTR) continue;
+        if(n <= 0) return GENERAL_ERROR;
+        buffer += n;
+        length -= n;
+    }
+    return 0;
+}
+
+// Read a line up to its newline (not kept), byte by byte so nothing after it is consumed
+int read_line(int fd, char * line, int size){
+    ssize_t n;
+    int length;
+
+    for(length = 0; length < size - 1; ){
+        n = read(fd, line + length, 1);
+        if(n < 0 && errno == EINTR) continue;
+        if(n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return TIMEOUT_ERROR;
+        if(n <= 0) return GENERAL_ERROR;
+        if(line[length] == '\n'){
+            line[length] = 0;
+            return 0;
+        }
+        length++;
+    }
+    return GENERAL_ERROR;
+}
+
+// Copy exactly length bytes from a connection to a file
+int copy_bytes(int from, int to, long length){
+    char * chunk;
+    ssize_t n;
+    int timeout;
+
+    chunk = malloc(SOCKET_CHUNK_SIZE);
+    if(!chunk) return MALLOC_ERROR;
+    timeout = 0;
+    while(length > 0){
+        n = read(from, chunk, length < SOCKET_CHUNK_SIZE ? length : SOCKET_CHUNK_SIZE);
+        if(n < 0 && errno == EINTR) continue;
+        timeout = n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+        if(n <= 0 || write(to, chunk, n) != n) break;
+        length -= n;
+    }
+    free(chunk);
+    if(timeout) return TIMEOUT_ERROR;
+    return length == 0 ? 0 : GENERAL_ERROR;
+}
+
+/* Read one request from a connection, run it and write the answer
+ * Input:   the server and the connection
+ * Output:  0 if the request was answered ok, ERROR otherwise
+ * Effect:  run the pipeline, may create a memory file for the alignment, may stop the server
+ */
+int answer_request(server_t * server, int fd){
+    char line[GENERAL_BUFFER_SIZE];
+    char answer[SERVER_ANSWER_SIZE];
+    char path[MEMFILE_PATH_SIZE];
+    family_t family;
+    int memfd, status, read_status;
+
+    memfd = -1;
+    status = GENERAL_ERROR;
+    family = server->settings;
+    read_status = read_line(fd, line, GENERAL_BUFFER_SIZE);
+    if(read_status == TIMEOUT_ERROR)
+        sprintf(answer, "failed\ttimeout\n");
+
+    else if(read_status != SUCCESS)
+        sprintf(answer, "failed\tunreadable request\n");
+
+    else if(strncmp(line, "PATH ", 5) == 0){
+        family.input_name = line + 5;
+        status = run_family(&family);
+        if(status != SUCCESS) sprintf(answer, "failed\tpipeline failed\n");
+
+    } else if(strncmp(line, "FASTA ", 6) == 0){
+        // The alignment is passed to the pipeline and to FastTree as a file held in memory
+        memfd = open_memfile("request", path);
+        read_status = memfd < 0 ? GENERAL_ERROR : copy_bytes(fd, memfd, atol(line + 6));
+        if(read_status == TIMEOUT_ERROR)
+            sprintf(answer, "failed\ttimeout\n");
+        else if(read_status != SUCCESS)
+            sprintf(answer, "failed\tcannot read the alignment\n");
+        else{
+            family.input_name = path;
+            status = run_family(&family);
+            if(status != SUCCESS) sprintf(answer, "failed\tpipeline failed\n");
+        }
+
+    } else if(strcmp(line, "QUIT") == 0){
+        pthread_mutex_lock(&server->lock);
+        server->stopping = 1;
+        pthread_mutex_unlock(&server->lock);
+        shutdown(server->listen_fd, SHUT_RDWR);
+        sprintf(answer, "ok\n");
+        send_all(fd, answer, strlen(answer));
+        return 0;
+
+    } else
+        sprintf(answer, "failed\tunknown request\n");
+
+    if(status == SUCCESS)
+        snprintf(answer, SERVER_ANSWER_SIZE, "ok\t%d\t%d\t%f\t%d\t%f\t%d\t%f\t%f\n", family.num_seq, family.length,
+                 family.bic.delta, family.bic.best_model, family.aic.delta, family.aic.best_model,
+                 family.bic.single_log_odd, family.bic.double_log_odd);
+    if(memfd >= 0) close(memfd);
+    send_all(fd, answer, strlen(answer));
+
+    pthread_mutex_lock(&server->lock);
+    server->served++;
+    pthread_mutex_unlock(&server->lock);
+    return status;
+}
+
+/* Loop of one thread of the daemon: accept a connection and answer it until the daemon stops
+ * The connections are close-on-exec so FastTree runs started by other threads do not keep them open, and time out
+ * after SERVER_TIMEOUT seconds without a byte so a silent client cannot hold the thread
+ * Input:   the server
+ * Output:  NULL
+ * Effect:  answer requests
+ */
+void * server_worker(void * arg){
+    server_t * server = arg;
+    struct timeval timeout = { SERVER_TIMEOUT, 0 };
+    int fd, stopping;
+
+    while(1){
+        pthread_mutex_lock(&server->lock);
+        stopping = server->stopping;
+        pthread_mutex_unlock(&server->lock);
+        if(stopping) break;
+
+        fd = accept4(server->listen_fd, NULL, NULL, SOCK_CLOEXEC);
+        if(fd < 0){
+            if(errno == EINTR || errno == ECONNABORTED) continue;
+            break;
+        }
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        answer_request(server, fd);
+        close(fd);
+    }
+    return NULL;
+}
+
+// Send one request of the load generator and read its whole answer
+int send_request(client_t * client, char * answer){
+    struct sockaddr_un address;
+    ssize_t n;
+    int fd, length;
+
+    set_address(&address, client->socket_name);
+    fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if(fd < 0) return OPEN_ERROR;
+    if(connect(fd, (struct sockaddr *) &address, sizeof(address)) != 0 || send_all(fd, client->payload, client->length) != SUCCESS){
+        close(fd);
+        return OPEN_ERROR;
+    }
+    for(length = 0; length < SERVER_ANSWER_SIZE - 1; ){
+        n = read(fd, answer + length, SERVER_ANSWER_SIZE - 1 - length);
+        if(n < 0 && errno == EINTR) continue;
+        if(n <= 0) break;
+        length += n;
+    }
+    answer[length] = 0;
+    close(fd);
+    return strncmp(answer, "ok\t", 3) == 0 ? 0 : GENERAL_ERROR;
+}
+
+// Loop of one connection of the load generator: send the next request until all are sent
+void * client_worker(void * arg){
+    client_t * client = arg;
+    char answer[SERVER_ANSWER_SIZE];
+    struct timespec start;
+    int i, status;
+
+    while(1){
+        pthread_mutex_lock(&client->lock);
+        i = client->next < client->num_requests ? client->next++ : -1;
+        pthread_mutex_unlock(&client->lock);
+        if(i < 0) break;
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        status = send_request(client, answer);
+        client->latency[i] = elapsed_ms(&start);
+
+        pthread_mutex_lock(&client->lock);
+        if(status != SUCCESS) client->failed++;
+        else strcpy(client->answer, answer);
+        pthread_mutex_unlock(&client->lock);
+    }
+    return NULL;
+}
+
+// Increasing latency
+int compare_latency(const void * a, const void * b){
+    double x = *(const double *) a;
+    double y = *(const double *) b;
+
+    return (x > y) - (x < y);
+}
+
+// Milliseconds since start on the monotonic clock
+double elapsed_ms(struct timespec * start){
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) * 1e3 + (now.tv_nsec - start->tv_nsec) / 1e6;
+}
@@ -0,0 +1,45 @@
+// File in HMMDecompositionDecision, created by Thien Le in July 2018
+
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <pthread.h>
+
+#include "pipeline.h"
+
+/* Requests of the daemon, one per connection. The client sends one line, then the alignment for FASTA, and the daemon
+ * answers one line before closing the connection:
+ *      PATH <file>         run the alignment in a file the daemon can read
+ *      FASTA <bytes>       run the alignment of the <bytes> bytes following the line
+ *      QUIT                stop the daemon once the requests running are answered
+ * Answer:  ok num_seq length delta_bic best_bic delta_aic best_aic single_log_odd double_log_odd, tab separated
+ *          or failed <reason>, failed timeout when the client stays silent for SERVER_TIMEOUT seconds
+ */
+#define SERVER_ANSWER_SIZE      256
+
+// Seconds a connection may go without sending or taking a byte before its request is dropped
+#define SERVER_TIMEOUT          10
+
+// Daemon answering requests on a Unix domain socket with a pool of threads started once
+typedef struct server {
+    char*           socket_name;    // path of the socket
+    int             listen_fd;      // listening socket, -1 until init_server succeeded
+    family_t        settings;       // settings of every alignment run
+    int             num_workers;    // number of requests answered at the same time
+    int             stopping;       // set by QUIT, no request is accepted after that
+    int             served;         // number of requests answered
+    pthread_mutex_t lock;           // protects stopping and served
+} server_t;
+
+// Constructor & destructor, the constructor binds the socket and the destructor removes it
+extern int init_server(server_t * server, char * socket_name, family_t * settings, int num_workers);
+extern void destroy_server(server_t * server);
+
+// Answer requests until a QUIT request
+extern int run_server(server_t * server);
+
+// Load generator: send the alignment of input_name num_requests times over num_connections connections at a time
+// and print the latency percentiles
+extern int run_client(char * socket_name, char * input_name, int num_requests, int num_connections);
+
+#endif
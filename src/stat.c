@@ -10,14 +10,12 @@
 
 #define CONST_E 2.7182818284590452353602874713
 
-int bic(msa_t * single, msa_t * first_double, msa_t* second_double, float * L, float * L1, float * L2, char * hmmbuild_stdout, int * best_model){
+int bic(msa_t * single, msa_t * first_double, msa_t* second_double, float * L, float * L1, float * L2, hmm_t * single_hmm, hmm_t * first_hmm, hmm_t * second_hmm, criterion_t * result){
     float prior_first;      //prior value for the first hmm
     float prior_second;     //prior value for the second hmm
     float first_model_log_odd;
     float second_model_log_odd;
     int i;
-    FILE * f;
-    char buffer[GENERAL_BUFFER_SIZE];       //placeholder for bit score (must be longer than the longest width of hmmsearch output)
 
 
     prior_first = 1.0 * first_double->num_seq / single->num_seq;
@@ -38,55 +36,23 @@ int bic(msa_t * single, msa_t * first_double, msa_t* second_double, float * L, f
         second_model_log_odd += L2[i] + log2f(prior_second);
     }
 
-    f = fopen(hmmbuild_stdout, "r");
-    if(!f) PRINT_AND_RETURN("open file error in bic calculation", OPEN_ERROR);
-
-    for(i = 0; i < 13; i++){
-        fgets(buffer, sizeof(buffer), f);
-    }
-    for(int i = 0; i < 4; i++){
-        fscanf(f, "%s", buffer);
-    }
-    int len = atoi(buffer);
-
-    fclose(f);
-    // Copied from hmmer.h in HMMER, 
-    /* Some notes:
- *   0. The model might be either in counts or probability form.
- *   1. t[0] is special: t[0][TMM,TMI,TMD] are the begin->M_1,I_0,D_1 entry probabilities,
- *      t[0][TIM,TII] are the I_0 transitions, and delete state 0 doesn't
- *      exist. Therefore D[0] transitions and mat[0] emissions are unused.
- *      To simplify some normalization code, we adopt a convention that these are set
- *      to valid probability distributions: 1.0 for t[0][TDM] and mat[0][0],
- *      and 0 for the rest.
- *   2. t[M] is also special: TMD and TDD are 0 because there is no next delete state;
- *      TDM is therefore 1.0 by definition. TMM and TDM are interpreted as the
- *      M->E and D->E end transitions. t[M][TDM] must be 1.0, therefore.
- */
-    // Thus, intial state has 1 free transition parameters, for each of the next M - 1 states, we have 2 more free transition parameters and the end state does not have any free transition  parameter
-    // Thus, total number of free transition parameter is 2 * M - 1
-
-    // Since there are 4 nucleotides, there are 3 free emission parameters for each match state or insertion state (which we actually don't have)
-    // Thus, total number of free parameter is 5 * M - 1
-    // Thus the difference in number of free parameter is 5 * M (the double model has twice as many paramters, plus the `prior' parameter)
-    int delta_k = 5 * len;
+    // The double model has the parameters of both its hmms plus the `prior' parameter, see hmm_num_parameters for the count of one hmm
+    int delta_k = hmm_num_parameters(first_hmm) + hmm_num_parameters(second_hmm) + 1 - hmm_num_parameters(single_hmm);
 
     float bic_double_over_single = log2f(single->num_seq) / log2f(CONST_E) * delta_k - 2.0 / log2f(CONST_E) * (second_model_log_odd - first_model_log_odd); 
-    printf("Delta BIC (2 v 1) is %f, log odd of double model is %f, log odd of single model is %f\n", bic_double_over_single, second_model_log_odd, first_model_log_odd);
-
-    if(bic_double_over_single > 0) *best_model = 1;
-    else *best_model = 2;
+    result->delta           = bic_double_over_single;
+    result->single_log_odd  = first_model_log_odd;
+    result->double_log_odd  = second_model_log_odd;
+    result->best_model      = bic_double_over_single > 0 ? 1 : 2;
     return 0;
 }
 
-int aic(msa_t * single, msa_t * first_double, msa_t* second_double, float * L, float * L1, float * L2, char * hmmbuild_stdout, int * best_model){
+int aic(msa_t * single, msa_t * first_double, msa_t* second_double, float * L, float * L1, float * L2, hmm_t * single_hmm, hmm_t * first_hmm, hmm_t * second_hmm, criterion_t * result){
     float prior_first;      //prior value for the first hmm
     float prior_second;     //prior value for the second hmm
     float first_model_log_odd;
     float second_model_log_odd;
     int i;
-    FILE * f;
-    char buffer[GENERAL_BUFFER_SIZE];       //placeholder for bit score (must be longer than the longest width of hmmsearch output)
 
 
     prior_first = 1.0 * first_double->num_seq / single->num_seq;
@@ -107,45 +73,14 @@ int aic(msa_t * single, msa_t * first_double, msa_t* second_double, float * L, f
         second_model_log_odd += L2[i] + log2f(prior_second);
     }
 
-    f = fopen(hmmbuild_stdout, "r");
-    if(!f) PRINT_AND_RETURN("open file error in bic calculation", OPEN_ERROR);
-
-    for(i = 0; i < 13; i++){
-        fgets(buffer, sizeof(buffer), f);
-    }
-    for(int i = 0; i < 4; i++){
-        fscanf(f, "%s", buffer);
-    }
-    int len = atoi(buffer);
-
-    fclose(f);
-    // Copied from hmmer.h in HMMER, 
-    /* Some notes:
- *   0. The model might be either in counts or probability form.
- *   1. t[0] is special: t[0][TMM,TMI,TMD] are the begin->M_1,I_0,D_1 entry probabilities,
- *      t[0][TIM,TII] are the I_0 transitions, and delete state 0 doesn't
- *      exist. Therefore D[0] transitions and mat[0] emissions are unused.
- *      To simplify some normalization code, we adopt a convention that these are set
- *      to valid probability distributions: 1.0 for t[0][TDM] and mat[0][0],
- *      and 0 for the rest.
- *   2. t[M] is also special: TMD and TDD are 0 because there is no next delete state;
- *      TDM is therefore 1.0 by definition. TMM and TDM are interpreted as the
- *      M->E and D->E end transitions. t[M][TDM] must be 1.0, therefore.
- */
-    // Thus, intial state has 1 free transition parameters, for each of the next M - 1 states, we have 2 more free transition parameters and the end state does not have any free transition  parameter
-    // Thus, total number of free transition parameter is 2 * M - 1
-
-    // Since there are 4 nucleotides, there are 3 free emission parameters for each match state or insertion state (which we actually don't have)
-    // Thus, total number of free parameter is 5 * M - 1
-    // Thus the difference in number of free parameter is 5 * M (the double model has twice as many paramters, plus the `prior' parameter)
-    printf("%d\n", len);
-    int delta_k = 5 * len;
+    // The double model has the parameters of both its hmms plus the `prior' parameter, see hmm_num_parameters for the count of one hmm
+    int delta_k = hmm_num_parameters(first_hmm) + hmm_num_parameters(second_hmm) + 1 - hmm_num_parameters(single_hmm);
 
     float bic_double_over_single = 2.0 * delta_k - 2.0 / log2f(CONST_E) * (second_model_log_odd - first_model_log_odd); 
-    printf("Delta AIC (2 v 1) is %f, log odd of double model is %f, log odd of single model is %f\n", bic_double_over_single, second_model_log_odd, first_model_log_odd);
-
-    if(bic_double_over_single > 0) *best_model = 1;
-    else *best_model = 2;
+    result->delta           = bic_double_over_single;
+    result->single_log_odd  = first_model_log_odd;
+    result->double_log_odd  = second_model_log_odd;
+    result->best_model      = bic_double_over_single > 0 ? 1 : 2;
     return 0;
 }
 
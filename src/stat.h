@@ -4,8 +4,17 @@
 #define STAT_H
 
 #include "msa.h"
+#include "hmm.h"
 
-extern int bic(msa_t * single, msa_t * first_double, msa_t* second_double, float * L, float * L1, float * L2, char * hmmbuild_stdout, int * best_model);
-extern int aic(msa_t * single, msa_t * first_double, msa_t* second_double, float * L, float * L1, float * L2, char * hmmbuild_stdout, int * best_model);
+// Outcome of a model selection criterion
+typedef struct criterion {
+    float   delta;              // criterion of the double model minus the one of the single model
+    float   single_log_odd;     // log odds of the sequences under the single model, in bits
+    float   double_log_odd;     // log odds of the sequences under the double model with its prior, in bits
+    int     best_model;         // 1 for the single model, 2 for the double model
+} criterion_t;
+
+extern int bic(msa_t * single, msa_t * first_double, msa_t* second_double, float * L, float * L1, float * L2, hmm_t * single_hmm, hmm_t * first_hmm, hmm_t * second_hmm, criterion_t * result);
+extern int aic(msa_t * single, msa_t * first_double, msa_t* second_double, float * L, float * L1, float * L2, hmm_t * single_hmm, hmm_t * first_hmm, hmm_t * second_hmm, criterion_t * result);
 
 #endif
\ No newline at end of file
@@ -7,217 +7,398 @@
 #include "tree.h"
 #include "utilities.h"
 
+#define INITIAL_TREE_CAPACITY 64
+#define INITIAL_NAME_CAPACITY 1024
+
 // Private functions
-int size_dfs(int node, int parent);
-int centroid_search(int node, int parent);
-int check(int node_a);
-int make_adjacent(int node_a, int node_b);
-int make_parent(int node_p, int node_c);
-int save_name(int cur_node, char * name);
-int init();
-
-/* Brute force algorithm to test whether a node is a leaf (has degree exactly 1 in a binary tree)
- * Input:   node to be tested
+int size_dfs(tree_t * tree, int node);
+int centroid_search(tree_t * tree, int node);
+void collect_leaves(tree_t * tree, int node, int skip, int * leaves, int * count);
+int check(tree_t * tree, int node_a);
+int add_node(tree_t * tree, int node);
+int make_parent(tree_t * tree, int node_p, int node_c);
+int append_name(tree_t * tree, char * name, int length, int terminate);
+int init(tree_t * tree);
+
+/* Initialize an empty tree
+ * Input:   pointer to the tree struct
+ * Output:  0 on success, ERROR otherwise
+ * Effect:  set fields in the input tree
+ */
+int init_tree(tree_t * tree){
+    if(!tree)       PRINT_AND_RETURN("tree is NULL in init_tree",   GENERAL_ERROR);
+
+    tree->num_nodes     = 0;
+    tree->capacity      = 0;
+    tree->parent_map    = NULL;
+    tree->first_child   = NULL;
+    tree->last_child    = NULL;
+    tree->next_sibling  = NULL;
+    tree->subtree_size  = NULL;
+    tree->leaf_index    = NULL;
+    tree->branch_length = NULL;
+    tree->support       = NULL;
+    tree->name_offset   = NULL;
+    tree->names         = NULL;
+    tree->names_length  = 0;
+    tree->names_capacity= 0;
+    tree->stack         = NULL;
+    tree->num_leaves    = 0;
+    tree->num_left      = 0;
+    tree->split_leaves  = NULL;
+    return 0;
+}
+
+/* A destructor for the tree struct that frees all mallocated fields
+ * This does not deallocate the struct itself if the struct was from heap memory
+ * Input:   tree struct
+ * Output:  nothing
+ * Effect:  freeing mallocated blocks
+ */
+void destroy_tree(tree_t * tree){
+    // Safe cheking: if the structure was never allocated then does nothing
+    if(!tree) return;
+
+    free(tree->parent_map);
+    free(tree->first_child);
+    free(tree->last_child);
+    free(tree->next_sibling);
+    free(tree->subtree_size);
+    free(tree->leaf_index);
+    free(tree->branch_length);
+    free(tree->support);
+    free(tree->name_offset);
+    free(tree->names);
+    free(tree->stack);
+    free(tree->split_leaves);
+    init_tree(tree);
+}
+
+/* Test whether a node is a leaf (has no children in the rooted tree)
+ * Input:   tree and node to be tested
  * Output:  1 if the node is a leave, 0 otherwise
  * Effect:  none
  */ 
-int is_leave(int cur_node){
-    int seen_one_neighbor = 0;
-    for(int i = 0; i < maxN; i++){
-        if(adj_mat[cur_node][i]){
-            if(seen_one_neighbor) return 0;
-            else seen_one_neighbor = 1;
-        }
-    }
-    return seen_one_neighbor;
+int is_leave(tree_t * tree, int cur_node){
+    return tree->first_child[cur_node] == -1;
 }
 
 /* Centroid decomposition of a tree into 2 subtrees by deleting the centroid edge. This requires the fields are already initialized by read_newick
- * Input:   pointer to write the 2 endpoints of the centroid edge to
+ * One pass computes the subtree sizes, the centroid is found by walking down the heavy path and a second pass emits the leaf set of both sides
+ * All traversals are iterative so deep (caterpillar) trees cost the same as balanced ones
+ * Input:   tree and pointer to write the 2 endpoints of the centroid edge to
  * Output:  0 on success, ERROR otherwise
- * Effect:  none
+ * Effect:  calls malloc, set subtree_size, num_leaves, num_left and split_leaves in the tree
  */ 
-int centroid_decomposition(int * left_subtree_root, int * right_subtree_root){
+int centroid_decomposition(tree_t * tree, int * left_subtree_root, int * right_subtree_root){
+    if(!tree)                           PRINT_AND_RETURN("tree is NULL in centroid decomposition",              GENERAL_ERROR);
     if(!left_subtree_root)              PRINT_AND_RETURN("left_subtree_root is NULL in cetroid decomposition",  GENERAL_ERROR);
     if(!right_subtree_root)             PRINT_AND_RETURN("right_subtree_root is NULL in centroid decomposition",GENERAL_ERROR);
 
     // Assuming input is already read by read_newick and is by definition a tree
-    size_dfs(0, -1);
-    *left_subtree_root      = centroid_search(0, -1);
-    *right_subtree_root     = parent_map[*left_subtree_root];
+    if(tree->num_nodes < 2)             PRINT_AND_RETURN("tree has no edge in centroid decomposition",          GENERAL_ERROR);
+    size_dfs(tree, 0);
+    if(tree->subtree_size[0] < 2)       PRINT_AND_RETURN("tree has less than 2 leaves in centroid decomposition", GENERAL_ERROR);
+    *left_subtree_root      = centroid_search(tree, 0);
+    if(IS_ERROR(*left_subtree_root))    PRINT_AND_RETURN("centroid search failed in centroid decomposition",    GENERAL_ERROR);
+    *right_subtree_root     = tree->parent_map[*left_subtree_root];
+
+    // Emit the leaf set of both sides, the left side goes in front
+    int count = 0;
+    free(tree->split_leaves);
+    tree->num_leaves        = tree->subtree_size[0];
+    tree->num_left          = tree->subtree_size[*left_subtree_root];
+    tree->split_leaves      = malloc(tree->num_leaves * sizeof(int));
+    if(!tree->split_leaves)             PRINT_AND_RETURN("malloc failed for split_leaves in centroid decomposition", MALLOC_ERROR);
+    collect_leaves(tree, *left_subtree_root, -1, tree->split_leaves, &count);
+    collect_leaves(tree, 0, *left_subtree_root, tree->split_leaves, &count);
     return 0;
 }
 
-#define READ_NAME_STATE 0
-#define OTHER_STATE     1
-
-#define incr_level(node_p, node_c, max_node) do{node_p = node_c; incr_node(node_c, max_node);} while(0)
-#define decr_level(node_p, node_c, max_node) do{node_c = node_p; node_p = parent_map[node_c];} while(0)
-#define incr_node(node, max_node)               node = ++max_node
-
-int read_newick(char * filename){
-    init();
-    FILE * f = freopen(filename, "r", stdin);
-    if(!f) PRINT_AND_RETURN("fail to open read_newick file",    OPEN_ERROR);
-
-    // FSM for reading newick format
-    int cur_state = READ_NAME_STATE;
-    int cur_node = 0;
-    int max_node = 0;
-    int parent_node = -1;
-    char cur_char = 0;
-    char cur_name[maxNameSize];
-    strclr(cur_name);
-
-    while(scanf("%c", &cur_char) == 1){
-        // printf("cur char is %c cur node is %d cur par is %d cur state is %d\n", cur_char, cur_node, parent_node, cur_state);
-        switch(cur_char){
-            case '(': //start of a new level and start of a new node
-                incr_level(parent_node, cur_node, max_node);
-                make_parent(parent_node, cur_node);
-                cur_state = READ_NAME_STATE;
-                break;
-            case ',': // start of new node end of old node
-                save_name(cur_node, cur_name);
-                incr_node(cur_node, max_node);
-                make_parent(parent_node, cur_node);
-                cur_state = READ_NAME_STATE;
+/* Read a tree in newick format. The whole file is read in one go and tokenized in a single pass:
+ * names are interned into the name arena of the tree, branch lengths (after ':') and support values (numeric labels of internal nodes) are kept
+ * Nodes are numbered in the order they are opened so the parent of a node always has a smaller index
+ * Input:   tree and name of the newick file
+ * Output:  0 on success, ERROR otherwise
+ * Effect:  open the file, calls malloc, set fields in the tree
+ */
+int read_newick(tree_t * tree, char * filename){
+    char * buffer;      // content of the file, null terminated
+    long size;          // size of the file
+    long pos;           // current position in the buffer
+    long end;           // end of the current label
+    char * num_end;     // end of a parsed number
+    int cur_node;       // node the next label or branch length belongs to
+    int new_node;
+    FILE * f;
+
+    if(!tree)       PRINT_AND_RETURN("tree is NULL in read_newick",     GENERAL_ERROR);
+    if(!filename)   PRINT_AND_RETURN("filename is NULL in read_newick", GENERAL_ERROR);
+    if(init(tree) != SUCCESS)   PRINT_AND_RETURN("init failed in read_newick",  MALLOC_ERROR);
+
+    // Read the whole file
+    f = fopen(filename, "r");
+    if(!f)          PRINT_AND_RETURN("fail to open read_newick file",    OPEN_ERROR);
+    fseek(f, 0, SEEK_END);
+    size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    buffer = malloc(size + 1);
+    if(!buffer)     {fclose(f); PRINT_AND_RETURN("malloc failed for buffer in read_newick", MALLOC_ERROR);}
+    if(size < 0 || (long) fread(buffer, 1, size, f) != size){
+        free(buffer); 
+        fclose(f); 
+        PRINT_AND_RETURN("fail to read read_newick file", OPEN_ERROR);
+    }
+    buffer[size] = 0;
+    fclose(f);
+
+    // Tokenize
+    cur_node = 0;
+    for(pos = 0; pos < size && buffer[pos] != ';'; pos++){
+        switch(buffer[pos]){
+            case '(': // start of a new level: the first child of the current node
+            case ',': // start of a new node: the next child of the same parent
+                if(buffer[pos] == ',' && cur_node == 0)   {free(buffer); PRINT_AND_RETURN("unbalanced ',' in read_newick", GENERAL_ERROR);}
+                new_node = tree->num_nodes;
+                if(make_parent(tree, buffer[pos] == '(' ? cur_node : tree->parent_map[cur_node], new_node) != SUCCESS)
+                                                            {free(buffer); return GENERAL_ERROR;}
+                cur_node = new_node;
                 break;
-            case ')': // end of level
-                save_name(cur_node, cur_name);
-                decr_level(parent_node, cur_node, max_node);
+            case ')': // end of level, the label and length that follow belong to the parent
+                if(cur_node == 0)                           {free(buffer); PRINT_AND_RETURN("unbalanced ')' in read_newick", GENERAL_ERROR);}
+                cur_node = tree->parent_map[cur_node];
                 break;
             case ':': 
-                cur_state = OTHER_STATE;
+                tree->branch_length[cur_node] = strtof(&buffer[pos + 1], &num_end);
+                pos = num_end - buffer - 1;
+                break;
+            case '[': // comment
+                while(pos < size && buffer[pos] != ']') pos++;
+                break;
+            case ' ': case '\t': case '\n': case '\r':
                 break;
-            default:
-                // printf("%c %d %s\n", cur_char, cur_state, cur_name);
-                if(cur_state == READ_NAME_STATE){
-                    char buf[2];
-                    buf[0] = cur_char;
-                    buf[1] = 0;
-                    strcat(cur_name, buf);
+            case '\'': // quoted label, '' stands for a quote
+                end = pos + 1;
+                tree->name_offset[cur_node] = tree->names_length;
+                while(end < size && (buffer[end] != '\'' || buffer[end + 1] == '\'')){
+                    if(buffer[end] == '\'') end++;
+                    if(append_name(tree, &buffer[end], 1, 0) != SUCCESS) {free(buffer); return MALLOC_ERROR;}
+                    end++;
                 }
+                if(append_name(tree, "", 0, 1) != SUCCESS)  {free(buffer); return MALLOC_ERROR;}
+                pos = end;
+                break;
+            default: // unquoted label
+                end = pos + strcspn(&buffer[pos], "(),:;[ \t\n\r");
+                tree->name_offset[cur_node] = tree->names_length;
+                if(append_name(tree, &buffer[pos], end - pos, 1) != SUCCESS) {free(buffer); return MALLOC_ERROR;}
+
+                // A numeric label on an internal node is its support value
+                if(!is_leave(tree, cur_node)){
+                    float support = strtof(&buffer[pos], &num_end);
+                    if(num_end == &buffer[end]) tree->support[cur_node] = support;
+                }
+                pos = end - 1;
         }
     }
 
-    fclose(f);
+    free(buffer);
+    if(cur_node != 0)   PRINT_AND_RETURN("unbalanced '(' in read_newick", GENERAL_ERROR);
     return 0;
 }
 
 // INTERNAL FUNCTION IMPLEMENTATIONS
 
 /* Helper function to check whether a node is in range
- * Input:   node to check
+ * Input:   tree and node to check
  * Output:  1 if the node is in range, 0 otherwise
  * Effect:  none
  */ 
-int check(int node_a){
-    if(0 <= node_a && node_a < maxN) return 1;
+int check(tree_t * tree, int node_a){
+    if(0 <= node_a && node_a < tree->num_nodes) return 1;
     else return 0;
 }
 
-/* Helper function to make a node adjacent to another in the adjacency matrix
- * Input:   2 nodes
+/* Helper function to append characters to the name arena of the tree, doubling the arena when it is full
+ * Input:   tree, the characters to append, their number and whether the name ends with them (null terminated)
  * Output:  0 on success, ERROR otherwise
- * Effect:  none
+ * Effect:  may call realloc, set the name arena of the tree
  */ 
-int make_adjacent(int node_a, int node_b){
-    if(!check(node_a) || !check(node_b))  PRINT_AND_RETURN("node out of range in make_adjacent", GENERAL_ERROR);
+int append_name(tree_t * tree, char * name, int length, int terminate){
+    int new_capacity;
 
-    adj_mat[node_a][node_b] = 1;
-    adj_mat[node_b][node_a] = 1;
+    if(tree->names_length + length + 1 > tree->names_capacity){
+        new_capacity = tree->names_capacity ? tree->names_capacity : INITIAL_NAME_CAPACITY;
+        while(tree->names_length + length + 1 > new_capacity) new_capacity *= 2;
+        char * names = realloc(tree->names, new_capacity);
+        if(!names)      PRINT_AND_RETURN("realloc failed in append_name",   MALLOC_ERROR);
+        tree->names = names;
+        tree->names_capacity = new_capacity;
+    }
+    memcpy(&tree->names[tree->names_length], name, length);
+    tree->names_length += length;
+    if(terminate) tree->names[tree->names_length++] = 0;
+    return 0;
+}
+
+/* Helper function to add a fresh node to the tree, growing the per-node arrays geometrically if needed
+ * Input:   tree and the node to be added (must be the next unused index)
+ * Output:  0 on success, ERROR otherwise
+ * Effect:  calls realloc, set fields in the tree
+ */ 
+int add_node(tree_t * tree, int node){
+    int new_capacity;
 
+    if(node != tree->num_nodes)         PRINT_AND_RETURN("node is not the next fresh node in add_node",  GENERAL_ERROR);
+
+    if(node == tree->capacity){
+        new_capacity = tree->capacity ? 2 * tree->capacity : INITIAL_TREE_CAPACITY;
+
+        int *   parent_map      = realloc(tree->parent_map,     new_capacity * sizeof(int));
+        if(parent_map)          tree->parent_map    = parent_map;
+        int *   first_child     = realloc(tree->first_child,    new_capacity * sizeof(int));
+        if(first_child)         tree->first_child   = first_child;
+        int *   last_child      = realloc(tree->last_child,     new_capacity * sizeof(int));
+        if(last_child)          tree->last_child    = last_child;
+        int *   next_sibling    = realloc(tree->next_sibling,   new_capacity * sizeof(int));
+        if(next_sibling)        tree->next_sibling  = next_sibling;
+        int *   subtree_size    = realloc(tree->subtree_size,   new_capacity * sizeof(int));
+        if(subtree_size)        tree->subtree_size  = subtree_size;
+        int *   leaf_index      = realloc(tree->leaf_index,     new_capacity * sizeof(int));
+        if(leaf_index)          tree->leaf_index    = leaf_index;
+        float * branch_length   = realloc(tree->branch_length,  new_capacity * sizeof(float));
+        if(branch_length)       tree->branch_length = branch_length;
+        float * support         = realloc(tree->support,        new_capacity * sizeof(float));
+        if(support)             tree->support       = support;
+        int *   name_offset     = realloc(tree->name_offset,    new_capacity * sizeof(int));
+        if(name_offset)         tree->name_offset   = name_offset;
+        int *   stack           = realloc(tree->stack,          new_capacity * sizeof(int));
+        if(stack)               tree->stack         = stack;
+
+        if(!parent_map || !first_child || !last_child || !next_sibling || !subtree_size || !leaf_index || !branch_length || !support || !name_offset || !stack)
+            PRINT_AND_RETURN("realloc failed in add_node",      MALLOC_ERROR);
+        tree->capacity = new_capacity;
+    }
+
+    tree->parent_map[node]      = -1;
+    tree->first_child[node]     = -1;
+    tree->last_child[node]      = -1;
+    tree->next_sibling[node]    = -1;
+    tree->subtree_size[node]    = 0;
+    tree->leaf_index[node]      = -1;
+    tree->branch_length[node]   = 0;
+    tree->support[node]         = -1;
+    tree->name_offset[node]     = 0;
+    tree->num_nodes++;
     return 0;
 }
 
-/* Helper function to make a node a parent of another 
+/* Helper function to make a fresh node a child of another. Children are appended so they keep the order of the input
  * Input:   2 nodes (order matters, the parent node comes first)
  * Output:  0 on success, ERROR otherwise
- * Effect:  none
+ * Effect:  set fields in the tree
  */ 
-int make_parent(int node_p, int node_c){
+int make_parent(tree_t * tree, int node_p, int node_c){
     // printf("make paret %d is paret f %d\n", node_p, node_c);
-    if(make_adjacent(node_p, node_c) != SUCCESS)    PRINT_AND_RETURN("node out of range in make_parent", GENERAL_ERROR);
+    if(!check(tree, node_p))                        PRINT_AND_RETURN("node out of range in make_parent", GENERAL_ERROR);
+    if(add_node(tree, node_c) != SUCCESS)           PRINT_AND_RETURN("add_node failed in make_parent", GENERAL_ERROR);
 
-    parent_map[node_c] = node_p;
+    tree->parent_map[node_c] = node_p;
+    if(tree->last_child[node_p] == -1)  tree->first_child[node_p] = node_c;
+    else                                tree->next_sibling[tree->last_child[node_p]] = node_c;
+    tree->last_child[node_p] = node_c;
     return 0;
 }
 
-/* Helper function to save name for a numeric node
- * Input:   node number and its name 
- * Output:  0 on success
- * Effect:  none
+/* Helper function to reset a tree to contain only the root. Offset 0 of the name arena holds the empty name shared by unnamed nodes
+ * Input:   tree
+ * Output:  0 on success, ERROR otherwise
+ * Effect:  may call malloc
  */ 
-int save_name(int cur_node, char * name){
-    // printf("save_name %d %s\n", cur_node, name);
-    if(strempty(name)){
-        char buf[1000];
-        snprintf(buf, 1000, "%d", cur_node);
-        strcpy(name_map[cur_node], buf);
-    } else {
-        strcpy(name_map[cur_node], name);
-    }
-    strclr(name); 
-
-    return 0;
+int init(tree_t * tree){
+    destroy_tree(tree);
+    if(append_name(tree, "", 0, 1) != SUCCESS) return MALLOC_ERROR;
+    return add_node(tree, 0);
 }
 
-/* Helper function to intialize global variables to some starting state
- * Input:   noner
+/* DFS routine to compute the size of the leaf set of the subtree rooted at some particular node
+ * The traversal is iterative on the preallocated stack of the tree: a node is pushed once to expand its children 
+ * and once more (complemented) to sum their sizes after all of them are done, so the stack never holds more than num_nodes entries
+ * Input:   tree and a node
  * Output:  0 on success
- * Effect:  none
+ * Effect:  set subtree_size in the tree
  */ 
-int init(){
-    for(int i = 0; i < maxN; i++){
-        subtree_size[i] = 0;
-        parent_map[i] = -1;
-        for(int j = 0; j < maxNameSize; j++){
-            name_map[i][j] = 0;
-        }
-        for(int j = 0; j < maxN; j++){
-            adj_mat[i][j] = 0;
+int size_dfs(tree_t * tree, int node){ 
+    int top = 0;
+    int child;
+
+    tree->stack[top++] = node;
+    while(top){
+        node = tree->stack[--top];
+        if(node >= 0){
+            tree->stack[top++] = ~node;
+            for(child = tree->first_child[node]; child != -1; child = tree->next_sibling[child])
+                tree->stack[top++] = child;
+        } else {
+            node = ~node;
+            tree->subtree_size[node] = is_leave(tree, node) ? 1 : 0;
+            for(child = tree->first_child[node]; child != -1; child = tree->next_sibling[child])
+                tree->subtree_size[node] += tree->subtree_size[child];
         }
     }
     return 0;
 }
 
-/* DFS routine to compute the size of the leaf set of the subtree rooted at some particular node
- * Input:   a node and it's parent (recursive state)
- * Output:  0 on success
+/* Greedy routine to find the centroid node of a tree by walking down the heaviest children. This requires subtree_size to have been initialized
+ * Input:   tree and the node to start from
+ * Output:  the centroid node of the tree, ERROR if the walk reaches a leaf
  * Effect:  none
  */ 
-int size_dfs(int node, int parent){ 
-        // printf("%d\n", node);
+int centroid_search(tree_t * tree, int node){ 
+    int is_centroid;
+    int heaviest_child;
+    int child;
 
-    if(is_leave(node)) subtree_size[node] = 1;
+    while(1){
+        is_centroid = 1;
+        heaviest_child = -1;
+        for(child = tree->first_child[node]; child != -1; child = tree->next_sibling[child]){
+            if(tree->subtree_size[child] > tree->subtree_size[0] / 2) 
+                is_centroid = 0;
 
-    for(int i = 0; i < maxN; i++){
-        if(!adj_mat[node][i] || i == parent || i == node) continue;
-        size_dfs(i, node);
-        subtree_size[node] += subtree_size[i];
+            if(heaviest_child == -1 || tree->subtree_size[child] > tree->subtree_size[heaviest_child]) 
+                heaviest_child = child;
+        }
+        if(is_centroid && tree->subtree_size[node] <= tree->subtree_size[0] / 2)
+            return node;
+        if(heaviest_child == -1)        PRINT_AND_RETURN("no centroid below a leaf in centroid_search",          GENERAL_ERROR);
+        node = heaviest_child;
     }
-    return 0;
 }
 
-/* Greedy routine to find the centroid node of a tree. This requires subtree_size to have been initialized
- * Input:   a node and it's parent (recursive state)
- * Output:  the centroid node of the tree
- * Effect:  none
+/* Preorder traversal writing the leaf_index of every leaf below a node into an array, skipping one subtree
+ * Children are pushed on the preallocated stack of the tree in reverse so they are visited in input order
+ * Input:   tree, the node to start from, the root of the subtree to skip (-1 for none), 
+ *          the output array and the number of leaves written so far
+ * Output:  none
+ * Effect:  write into the output array and increase the count
  */ 
-int centroid_search(int node, int parent){ 
-    int is_centroid = 1;
-    int heaviest_child = 0;
-    for(int i = 0; i < maxN; i++){
-        if(!adj_mat[node][i] || i == parent || i == node) continue;
-        if(subtree_size[i] > subtree_size[0] / 2) 
-            is_centroid = 0;
-
-        if(heaviest_child == 0 || subtree_size[i] > subtree_size[heaviest_child]) 
-            heaviest_child = i;
+void collect_leaves(tree_t * tree, int node, int skip, int * leaves, int * count){
+    int top = 0;
+    int base, child, tmp, i;
+
+    tree->stack[top++] = node;
+    while(top){
+        node = tree->stack[--top];
+        if(is_leave(tree, node)) leaves[(*count)++] = tree->leaf_index[node];
+
+        base = top;
+        for(child = tree->first_child[node]; child != -1; child = tree->next_sibling[child])
+            if(child != skip) tree->stack[top++] = child;
+        for(i = 0; i < (top - base) / 2; i++){
+            tmp = tree->stack[base + i];
+            tree->stack[base + i] = tree->stack[top - 1 - i];
+            tree->stack[top - 1 - i] = tmp;
+        }
     }
-    if(is_centroid && subtree_size[node] <= subtree_size[0] / 2)
-        return node;
-    return centroid_search(heaviest_child, node);
 }
-
@@ -3,20 +3,40 @@
 #ifndef TREE_H
 #define TREE_H
 
-#define maxN 			10000 // these are number of nodes, not just number of leaves
-#define maxNameSize 	1000
+// Structure for a rooted tree read from a newick file. Node 0 is the root and every node has a parent with a smaller index
+// Children are kept as linked lists (first_child/next_sibling) so every array is sized to the number of nodes
+typedef struct tree {
+    int     num_nodes;      // number of nodes in the tree
+    int     capacity;       // allocated length of the per-node arrays
+    int*    parent_map;     // parent of each node, -1 for the root
+    int*    first_child;    // first child of each node, -1 if none
+    int*    last_child;     // last child of each node (to append children in input order), -1 if none
+    int*    next_sibling;   // next child of the same parent, -1 if none
+    int*    subtree_size;   // size of the leaf set of the subtree rooted at each node
+    int*    leaf_index;     // index of the sequence a leaf stands for in the input msa, -1 for internal or unmapped nodes
+    float*  branch_length;  // length of the edge to the parent, 0 if not given
+    float*  support;        // support value of each internal node, -1 if not given
+    int*    name_offset;    // offset of the name of each node in the name arena (offset 0 is the empty name)
+    char*   names;          // name arena holding the null terminated names of all nodes
+    int     names_length;   // used length of the name arena
+    int     names_capacity; // allocated length of the name arena
+    int*    stack;          // explicit traversal stack with room for every node, reused by all traversals
 
-// Size of subtree rooted at a particular node
-int subtree_size[maxN]; 
-int parent_map[maxN];
-char name_map[maxN][maxNameSize];
+    // Output of centroid_decomposition
+    int     num_leaves;     // size of the leaf set of the whole tree
+    int     num_left;       // number of leaves on the side of the left subtree root
+    int*    split_leaves;   // leaf_index of every leaf, the num_left leaves of the left side first and then the right side
+} tree_t;
 
-int adj_mat[maxN][maxN];
+// Name of a node
+#define tree_name(tree, node)   ((tree)->names + (tree)->name_offset[node])
 
-int debug_counter;
+// Constructor & destructor
+extern int init_tree(tree_t * tree);
+extern void destroy_tree(tree_t * tree);
 
-extern int centroid_decomposition(int * left_subtree_root, int * right_subtree_root);
-extern int read_newick(char * filename);
-extern int is_leave(int cur_node);
+extern int centroid_decomposition(tree_t * tree, int * left_subtree_root, int * right_subtree_root);
+extern int read_newick(tree_t * tree, char * filename);
+extern int is_leave(tree_t * tree, int cur_node);
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,888 @@
+// File in HMMDecompositionDecision, created by Thien Le in July 2018
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "viterbi.h"
+#include "kernel.h"
+#include "utilities.h"
+
+// Rows of the msa scored by one thread
+typedef struct score_chunk {
+    profile_t*  profile;    // profile the rows are scored against
+    msa_t*      msa;        // msa holding the rows
+    int         first;      // first row of the chunk
+    int         last;       // one past the last row of the chunk
+    float*      scores;     // score of every row of the msa
+    int*        column_node;// node of every match column of the msa and 0 elsewhere, NULL to score without the alignment
+    int         band;       // number of nodes on each side of the path scored with column_node, 0 for the path alone
+    kernel_t*   kernel;     // kernels the rows are scored with
+    int         batch;      // whether the rows may be scored several at a time
+    int         status;     // return value of score_rows
+} score_chunk_t;
+
+// Row of the msa and its number of residues, to sort the rows of a chunk by length
+typedef struct row_length {
+    int         row;
+    int         length;
+} row_length_t;
+
+// DP rows and residue codes of a thread, kept from one block to the next so a thread that lives across alignments,
+// a worker of --serve, allocates them once. They are freed when the thread exits
+typedef struct scratch {
+    float*      dp;
+    size_t      dp_size;    // bytes of dp
+    char*       dsq;
+    size_t      dsq_size;
+} scratch_t;
+
+// Private function templates
+float   viterbi_scalar          (profile_t * profile, char * dsq, int L, float * dp);
+float   viterbi_striped         (profile_t * profile, char * dsq, int L, float * dp);
+float   viterbi_single          (kernel_t * kernel, profile_t * profile, char * dsq, int L, float * dp);
+float   viterbi_banded          (profile_t * profile, char * dsq, int L, int * node, int band, float * dp);
+float   path_score              (profile_t * profile, trace_t * trace, int L);
+int     path_nodes              (char * sequence, int N, int * column_node, char * dsq, int * node);
+int     score_blocks            (profile_t * profile, msa_t * msa, int * column_node, int band, int num_threads, float * scores);
+int     score_with_kernel       (kernel_t * kernel, int batch, profile_t * profile, msa_t * msa, float * scores);
+int     digitize                (char * sequence, int N, char * dsq);
+float   bit_score               (float score, int L);
+int     compare_length          (const void * a, const void * b);
+int     score_rows              (score_chunk_t * chunk);
+int     score_rows_batch        (score_chunk_t * chunk);
+kernel_t* batch_kernel          (score_chunk_t * chunk);
+int     score_rows_aligned      (score_chunk_t * chunk);
+void*   score_chunk             (void * chunk);
+int     get_scratch             (size_t dp_size, size_t dsq_size, float ** dp, char ** dsq);
+void    make_scratch_key        (void);
+void    free_scratch            (void * scratch);
+
+// Kernels set by set_kernel, the fastest the cpu supports if NULL
+kernel_t * selected_kernel = NULL;
+
+// Key of the scratch_t of each thread
+static pthread_key_t scratch_key;
+static pthread_once_t scratch_once = PTHREAD_ONCE_INIT;
+
+/* Constructor for the profile, the profile is empty until build_profile is called
+ * Input:   pointer to the profile
+ * Output:  0 on success, ERROR otherwise
+ * Effect:  set fields in the profile
+ */
+int init_profile(profile_t * profile){
+    if(!profile)    PRINT_AND_RETURN("profile is NULL in init_profile",     GENERAL_ERROR);
+
+    profile->M      = 0;
+    profile->Q      = 0;
+    profile->msc    = NULL;
+    profile->tsc    = NULL;
+    profile->node_msc = NULL;
+    profile->node_tsc = NULL;
+    return 0;
+}
+
+/* Destructor for the profile that frees all mallocated fields
+ * Input:   pointer to the profile
+ * Output:  nothing
+ * Effect:  freeing mallocated blocks
+ */
+void destroy_profile(profile_t * profile){
+    if(!profile) return;
+
+    free(profile->msc);
+    free(profile->tsc);
+    free(profile->node_msc);
+    free(profile->node_tsc);
+    init_profile(profile);
+}
+
+/* Configure an hmm for local multihit alignment as hmmsearch does and store its scores striped
+ * Local entry into match state k is weighted by the probability that a global path uses it (occupancy),
+ * every match and delete state may exit to the end state, and the insert states score 0 since they emit the background
+ * Input:   an initialized profile and the hmm
+ * Output:  0 on success, ERROR otherwise
+ * Effect:  calls malloc, set fields in the profile
+ */
+int build_profile(profile_t * profile, hmm_t * hmm){
+    double * occupancy;     // probability that a global path goes through match state k
+    double Z, p, background;
+    int M, Q, k, q, z, x, c, s;
+    size_t msc_size, tsc_size, cell;
+
+    if(!profile)        PRINT_AND_RETURN("profile is NULL in build_profile",    GENERAL_ERROR);
+    if(!hmm)            PRINT_AND_RETURN("hmm is NULL in build_profile",        GENERAL_ERROR);
+    if(hmm->M < 1)      PRINT_AND_RETURN("hmm is not built in build_profile",   GENERAL_ERROR);
+    destroy_profile(profile);
+
+    M = profile->M  = hmm->M;
+    Q = profile->Q  = (M + VITERBI_LANES - 1) / VITERBI_LANES;
+    msc_size        = (size_t) NUM_RESIDUE_CODES * Q * VITERBI_LANES;
+    tsc_size        = (size_t) PROFILE_NUM_TRANSITIONS * Q * VITERBI_LANES;
+    if(posix_memalign((void **) &profile->msc, MSA_ALIGNMENT, msc_size * sizeof(float)) != 0) profile->msc = NULL;
+    if(posix_memalign((void **) &profile->tsc, MSA_ALIGNMENT, tsc_size * sizeof(float)) != 0) profile->tsc = NULL;
+    profile->node_msc = malloc((M + 1) * NUM_RESIDUE_CODES * sizeof(float));
+    profile->node_tsc = malloc((M + 1) * PROFILE_NUM_TRANSITIONS * sizeof(float));
+    occupancy = malloc((M + 1) * sizeof(double));
+    if(!profile->msc || !profile->tsc || !profile->node_msc || !profile->node_tsc || !occupancy){
+        free(occupancy);
+        destroy_profile(profile);
+        PRINT_AND_RETURN("malloc failed in build_profile",                      MALLOC_ERROR);
+    }
+
+    // Lanes past M stay at -infinity so they never take part in a path
+    for(cell = 0; cell < msc_size; cell++) profile->msc[cell] = -INFINITY;
+    for(cell = 0; cell < tsc_size; cell++) profile->tsc[cell] = -INFINITY;
+
+    // Occupancy of every match state and the normalization of the local entries
+    occupancy[1] = hmm_transition(hmm, 0, HMM_TMM) + hmm_transition(hmm, 0, HMM_TMI);
+    for(k = 2; k <= M; k++)
+        occupancy[k] = occupancy[k - 1] * (hmm_transition(hmm, k - 1, HMM_TMM) + hmm_transition(hmm, k - 1, HMM_TMI))
+                     + (1.0 - occupancy[k - 1]) * hmm_transition(hmm, k - 1, HMM_TDM);
+    for(Z = 0, k = 1; k <= M; k++) Z += occupancy[k] * (M - k + 1);
+
+    for(k = 1; k <= M; k++){
+        q = (k - 1) % Q;
+        z = (k - 1) / Q;
+
+        // Transitions into node k
+        profile_tsc(profile, PROFILE_TBM, q)[z] = log(occupancy[k] / Z);
+        if(k > 1){
+            profile_tsc(profile, PROFILE_TMM, q)[z] = logf(hmm_transition(hmm, k - 1, HMM_TMM));
+            profile_tsc(profile, PROFILE_TIM, q)[z] = logf(hmm_transition(hmm, k - 1, HMM_TIM));
+            profile_tsc(profile, PROFILE_TDM, q)[z] = logf(hmm_transition(hmm, k - 1, HMM_TDM));
+        }
+
+        // Transitions out of node k, there is no insert state and no delete state after the last node
+        if(k < M){
+            profile_tsc(profile, PROFILE_TMD, q)[z] = logf(hmm_transition(hmm, k, HMM_TMD));
+            profile_tsc(profile, PROFILE_TMI, q)[z] = logf(hmm_transition(hmm, k, HMM_TMI));
+            profile_tsc(profile, PROFILE_TII, q)[z] = logf(hmm_transition(hmm, k, HMM_TII));
+            profile_tsc(profile, PROFILE_TDD, q)[z] = logf(hmm_transition(hmm, k, HMM_TDD));
+        }
+
+        // Match emissions, a degenerate residue scores the odds of the set of nucleotides it stands for
+        for(c = 1; c < NUM_RESIDUE_CODES; c++){
+            p = background = 0;
+            for(x = 0; x < HMM_ALPHABET_SIZE; x++)
+                if((c >> x) & 1){
+                    p += hmm_match(hmm, k, x);
+                    background += 1.0 / HMM_ALPHABET_SIZE;
+                }
+            profile_msc(profile, c, q)[z] = log(p / background);
+        }
+    }
+
+    // Node-major copy
+    for(c = 0; c < NUM_RESIDUE_CODES; c++)          profile_node_msc(profile, 0)[c] = -INFINITY;
+    for(s = 0; s < PROFILE_NUM_TRANSITIONS; s++)    profile_node_tsc(profile, 0)[s] = -INFINITY;
+    for(k = 1; k <= M; k++){
+        q = (k - 1) % Q;
+        z = (k - 1) / Q;
+        for(c = 0; c < NUM_RESIDUE_CODES; c++)          profile_node_msc(profile, k)[c] = profile_msc(profile, c, q)[z];
+        for(s = 0; s < PROFILE_NUM_TRANSITIONS; s++)    profile_node_tsc(profile, k)[s] = profile_tsc(profile, s, q)[z];
+    }
+
+    // Transitions of the padding lanes stay at -infinity, check that the model has no NaN
+    for(cell = 0; cell < tsc_size; cell++)
+        if(isnan(profile->tsc[cell])){
+            free(occupancy);
+            destroy_profile(profile);
+            PRINT_AND_RETURN("hmm has invalid transitions in build_profile",   GENERAL_ERROR);
+        }
+
+    free(occupancy);
+    return 0;
+}
+
+/* Score every sequence of an msa against a profile: the gaps of each row are removed and the Viterbi score of the sequence
+ * under the local multihit model is reported in bits against the null model of hmmsearch, as the patched hmmsearch did
+ * The rows are cut into one block per thread
+ * Input:   the profile, the msa (owning or a view), the number of threads and an array of num_seq scores
+ * Output:  0 on success, ERROR otherwise
+ * Effect:  calls malloc, starts up to num_threads - 1 threads, set the scores
+ */
+int score_msa(profile_t * profile, msa_t * msa, int num_threads, float * scores){
+    if(!profile)        PRINT_AND_RETURN("profile is NULL in score_msa",        GENERAL_ERROR);
+    if(!msa)            PRINT_AND_RETURN("msa is NULL in score_msa",            GENERAL_ERROR);
+    if(!scores)         PRINT_AND_RETURN("scores is NULL in score_msa",         GENERAL_ERROR);
+    if(profile->M < 1)  PRINT_AND_RETURN("profile is not built in score_msa",   GENERAL_ERROR);
+
+    return score_blocks(profile, msa, NULL, 0, num_threads, scores);
+}
+
+/* Score every sequence of an msa against a profile along the path the alignment gives it, the msa sharing its columns
+ * with the one the hmm was built from. With band 0 the score is the one of that path in the local multihit model:
+ * the residues before the first and after the last match state are emitted by the flanking states, the others follow
+ * the trace hmmbuild counted. With a positive band the score is the best path through the nodes at most band away from
+ * the node each residue is aligned to, which also lets the alignment of the ends move. A row without a match state falls
+ * back to the full Viterbi score. Both are at most the Viterbi score of score_msa and use the same null model
+ * Input:   the profile, the hmm it was built from, the msa (owning or a view), the band, the number of threads
+ *          and an array of num_seq scores
+ * Output:  0 on success, ERROR otherwise
+ * Effect:  calls malloc, starts up to num_threads - 1 threads, set the scores
+ */
+int score_msa_aligned(profile_t * profile, hmm_t * hmm, msa_t * msa, int band, int num_threads, float * scores){
+    int * column_node;      // node of every match column, 0 for the insert columns
+    int k, status;
+
+    if(!profile)        PRINT_AND_RETURN("profile is NULL in score_msa_aligned",        GENERAL_ERROR);
+    if(!hmm)            PRINT_AND_RETURN("hmm is NULL in score_msa_aligned",            GENERAL_ERROR);
+    if(!msa)            PRINT_AND_RETURN("msa is NULL in score_msa_aligned",            GENERAL_ERROR);
+    if(!scores)         PRINT_AND_RETURN("scores is NULL in score_msa_aligned",         GENERAL_ERROR);
+    if(profile->M < 1 || profile->M != hmm->M)
+                        PRINT_AND_RETURN("profile is not built from hmm in score_msa_aligned",  GENERAL_ERROR);
+    if(band < 0)        PRINT_AND_RETURN("band must not be negative in score_msa_aligned",      GENERAL_ERROR);
+    if(hmm->map[hmm->M] > msa->N)
+                        PRINT_AND_RETURN("hmm is not built from the columns of msa in score_msa_aligned",   GENERAL_ERROR);
+
+    column_node = calloc(msa->N, sizeof(int));
+    if(!column_node)    PRINT_AND_RETURN("malloc failed in score_msa_aligned",          MALLOC_ERROR);
+    for(k = 1; k <= hmm->M; k++) column_node[hmm->map[k] - 1] = k;
+
+    status = score_blocks(profile, msa, column_node, band, num_threads, scores);
+    free(column_node);
+    return status;
+}
+
+/* Set the kernels used by the scoring functions
+ * Input:   the name of a kernel (scalar, sse2, sse4.1, avx2 or avx512) or NULL for the fastest the cpu supports
+ * Output:  0 on success, ERROR if there is no such kernel or the cpu does not support it
+ * Effect:  set the kernels of every later scoring
+ */
+int set_kernel(char * name){
+    kernel_t * kernel;
+
+    if(!name){
+        selected_kernel = NULL;
+        return 0;
+    }
+    kernel = find_kernel(name);
+    if(!kernel)                 PRINT_AND_RETURN("unknown kernel in set_kernel",                GENERAL_ERROR);
+    if(!kernel->supported())    PRINT_AND_RETURN("kernel not supported by the cpu in set_kernel",   GENERAL_ERROR);
+    selected_kernel = kernel;
+    return 0;
+}
+
+// Name of the kernels used by the scoring functions
+char * kernel_name(void){
+    return (selected_kernel ? selected_kernel : best_kernel())->name;
+}
+
+/* Self-test of the kernels: score an msa with every kernel the cpu supports, both several sequences at a time and one
+ * at a time, and check that every score is the one of the scalar kernel
+ * Input:   the profile and the msa
+ * Output:  0 if all the scores are identical, ERROR otherwise
+ * Effect:  calls malloc
+ */
+int check_kernels(profile_t * profile, msa_t * msa){
+    float * reference, * scores;
+    int i, batch, mismatch;
+
+    if(!profile)        PRINT_AND_RETURN("profile is NULL in check_kernels",        GENERAL_ERROR);
+    if(!msa)            PRINT_AND_RETURN("msa is NULL in check_kernels",            GENERAL_ERROR);
+    if(profile->M < 1)  PRINT_AND_RETURN("profile is not built in check_kernels",   GENERAL_ERROR);
+    if(msa->num_seq == 0) return 0;
+
+    reference = malloc(msa->num_seq * sizeof(float));
+    scores = malloc(msa->num_seq * sizeof(float));
+    if(!reference || !scores){
+        free(reference);
+        free(scores);
+        PRINT_AND_RETURN("malloc failed in check_kernels",          MALLOC_ERROR);
+    }
+
+    mismatch = score_with_kernel(&kernels[0], 0, profile, msa, reference) != SUCCESS;
+    for(i = 0; i < num_kernels && !mismatch; i++){
+        if(!kernels[i].supported()) continue;
+        for(batch = 0; batch < 2 && !mismatch; batch++){
+            if(score_with_kernel(&kernels[i], batch, profile, msa, scores) != SUCCESS
+            || memcmp(scores, reference, msa->num_seq * sizeof(float)) != 0){
+                fprintf(stderr, "kernel %s gives different scores\n", kernels[i].name);
+                mismatch = 1;
+            }
+        }
+    }
+
+    free(reference);
+    free(scores);
+    if(mismatch)        PRINT_AND_RETURN("kernels disagree in check_kernels",       GENERAL_ERROR);
+    return 0;
+}
+
+
+//INTERNAL FUNCTIONS IMPLEMENTATIONS
+
+/* Score the rows of an msa, cut into one block per thread
+ * Input:   the profile, the msa, the node of each column (NULL for plain Viterbi), the band, the number of threads and the scores
+ * Output:  0 on success, ERROR otherwise
+ * Effect:  calls malloc, starts up to num_threads - 1 threads, set the scores
+ */
+int score_blocks(profile_t * profile, msa_t * msa, int * column_node, int band, int num_threads, float * scores){
+    score_chunk_t * chunks;
+    pthread_t * threads;
+    int * started;
+    int status;
+    int i; //loop variable
+
+    if(msa->num_seq == 0) return 0;
+
+    if(num_threads > msa->num_seq)  num_threads = msa->num_seq;
+    if(num_threads < 1)             num_threads = 1;
+
+    chunks = malloc(num_threads * sizeof(score_chunk_t));
+    threads = malloc(num_threads * sizeof(pthread_t));
+    started = malloc(num_threads * sizeof(int));
+    if(!chunks || !threads || !started){
+        free(chunks);
+        free(threads);
+        free(started);
+        PRINT_AND_RETURN("malloc failed in score_blocks",   MALLOC_ERROR);
+    }
+
+    for(i = 0; i < num_threads; i++){
+        chunks[i].profile   = profile;
+        chunks[i].msa       = msa;
+        chunks[i].first     = (int) ((long long) msa->num_seq * i / num_threads);
+        chunks[i].last      = (int) ((long long) msa->num_seq * (i + 1) / num_threads);
+        chunks[i].scores    = scores;
+        chunks[i].column_node = column_node;
+        chunks[i].band      = band;
+        chunks[i].kernel    = selected_kernel ? selected_kernel : best_kernel();
+        chunks[i].batch     = 1;
+        chunks[i].status    = SUCCESS;
+    }
+
+    // Same as run_chunks in msa.c: the first block on the calling thread, a block whose thread cannot start is run here too
+    for(i = 1; i < num_threads; i++)
+        started[i] = pthread_create(&threads[i], NULL, score_chunk, &chunks[i]) == 0;
+    score_chunk(&chunks[0]);
+    for(i = 1; i < num_threads; i++){
+        if(started[i])  pthread_join(threads[i], NULL);
+        else            score_chunk(&chunks[i]);
+    }
+
+    for(status = SUCCESS, i = 0; i < num_threads; i++)
+        if(chunks[i].status != SUCCESS) status = chunks[i].status;
+    free(chunks);
+    free(threads);
+    free(started);
+    if(status != SUCCESS)   PRINT_AND_RETURN("scoring failed in score_blocks", GENERAL_ERROR);
+    return 0;
+}
+
+/* Score all the rows of an msa in one block on the calling thread with the given kernels
+ * Input:   the kernels, whether the rows may be scored several at a time, the profile, the msa and the scores
+ * Output:  0 on success, ERROR otherwise
+ * Effect:  calls malloc, set the scores
+ */
+int score_with_kernel(kernel_t * kernel, int batch, profile_t * profile, msa_t * msa, float * scores){
+    score_chunk_t chunk = { profile, msa, 0, msa->num_seq, scores, NULL, 0, kernel, batch, SUCCESS };
+
+    return score_rows(&chunk);
+}
+
+/* Viterbi score of one sequence with the striped kernel, or the scalar one if the kernels have no SSE2
+ * Input:   the kernels, the profile, the residue codes of the sequence, its length and room for 3 x Q x VITERBI_LANES floats
+ * Output:  the score in nats
+ * Effect:  overwrite dp
+ */
+float viterbi_single(kernel_t * kernel, profile_t * profile, char * dsq, int L, float * dp){
+#ifdef __SSE2__
+    if(kernel->striped) return viterbi_striped(profile, dsq, L, dp);
+#endif
+    return viterbi_scalar(profile, dsq, L, dp);
+}
+
+/* Residue codes of an aligned sequence without its gaps
+ * Input:   the aligned sequence, its length and room for N codes
+ * Output:  the number of residues
+ * Effect:  set dsq
+ */
+int digitize(char * sequence, int N, char * dsq){
+    int c, L, code;
+
+    for(L = 0, c = 0; c < N && sequence[c]; c++)
+        if((code = residue_code(sequence[c]))) dsq[L++] = code;
+    return L;
+}
+
+/* Viterbi score of a sequence of length L in bits against the null model of hmmsearch
+ * A sequence without residues carries no evidence for either model and scores 0
+ * Input:   the Viterbi score in nats and the length of the sequence
+ * Output:  the bit score
+ * Effect:  none
+ */
+float bit_score(float score, int L){
+    float null;     // score of the sequence under the null model
+
+    if(L == 0) return 0;
+    null = L * logf((float) L / (L + 1)) + logf(1.0f / (L + 1));
+    return (score - null) / M_LN2;
+}
+
+int compare_length(const void * a, const void * b){
+    return ((row_length_t *) a)->length - ((row_length_t *) b)->length;
+}
+
+/* Score the rows of one block. Blocks of at least VITERBI_LANES rows on a model whose DP rows fit in cache go to the
+ * inter-sequence kernel, which needs no lazy delete passes, the other rows are scored one at a time
+ * Input:   the block
+ * Output:  0 on success, ERROR otherwise
+ * Effect:  calls malloc, set the scores of the rows of the block
+ */
+int score_rows(score_chunk_t * chunk){
+    profile_t * profile = chunk->profile;
+    msa_t * msa = chunk->msa;
+    float * dp;             // match, insert and delete rows of the DP matrix
+    char * dsq;             // residue codes of the sequence without its gaps
+    int i, L;
+
+    if(chunk->column_node)
+        return score_rows_aligned(chunk);
+    if(chunk->batch && batch_kernel(chunk))
+        return score_rows_batch(chunk);
+
+    if(get_scratch(3 * (size_t) profile->Q * VITERBI_LANES * sizeof(float), msa->N + 1, &dp, &dsq) != SUCCESS)
+        PRINT_AND_RETURN("malloc failed in score_rows",     MALLOC_ERROR);
+
+    for(i = chunk->first; i < chunk->last; i++){
+        L = digitize(msa_sequence(msa, i), msa->N, dsq);
+        if(L == 0){
+            chunk->scores[i] = 0;
+            continue;
+        }
+        chunk->scores[i] = bit_score(viterbi_single(chunk->kernel, profile, dsq, L, dp), L);
+    }
+    return 0;
+}
+
+/* Widest inter-sequence kernel, up to the one of the block, the cpu supports that has no more lanes than the block has rows
+ * and whose DP row fits in cache
+ * Input:   the block
+ * Output:  the kernel, NULL if there is none
+ * Effect:  none
+ */
+kernel_t * batch_kernel(score_chunk_t * chunk){
+    kernel_t * kernel;
+
+    for(kernel = chunk->kernel; kernel >= kernels; kernel--)
+        if(kernel->batch && kernel->supported() && chunk->last - chunk->first >= kernel->lanes
+        && (size_t) chunk->profile->M * kernel->lanes <= VITERBI_BATCH_MAX_CELLS) return kernel;
+    return NULL;
+}
+
+/* Score the rows of one block with the inter-sequence kernel, as many at a time as it has lanes
+ * The rows are sorted by length so the sequences sharing the lanes end at about the same time
+ * Input:   the block
+ * Output:  0 on success, ERROR otherwise
+ * Effect:  calls malloc, set the scores of the rows of the block
+ */
+int score_rows_batch(score_chunk_t * chunk){
+    profile_t * profile = chunk->profile;
+    msa_t * msa = chunk->msa;
+    row_length_t * order;       // rows of the block sorted by length
+    float * dp;                 // match, insert and delete vectors of every node
+    char * dsq;                 // residue codes of the sequences of the lanes, one after the other
+    int L[KERNEL_MAX_LANES];    // length of the sequence of each lane, 0 for an empty lane
+    float score[KERNEL_MAX_LANES];  // Viterbi score of each lane
+    kernel_t * kernel = batch_kernel(chunk);
+    int lanes = kernel->lanes;
+    int num_rows, stride, i, j, lane;
+    char * sequence;
+
+    num_rows = chunk->last - chunk->first;
+    stride = msa->N + 1;
+    order = malloc(num_rows * sizeof(row_length_t));
+    if(!order || get_scratch(3 * (size_t) (profile->M + 1) * lanes * sizeof(float), (size_t) lanes * stride, &dp, &dsq) != SUCCESS){
+        free(order);
+        PRINT_AND_RETURN("malloc failed in score_rows_batch",      MALLOC_ERROR);
+    }
+
+    // Bucket the rows by length
+    for(i = 0; i < num_rows; i++){
+        order[i].row = chunk->first + i;
+        sequence = msa_sequence(msa, order[i].row);
+        order[i].length = 0;
+        for(j = 0; j < msa->N && sequence[j]; j++)
+            if(residue_code(sequence[j])) order[i].length++;
+    }
+    qsort(order, num_rows, sizeof(row_length_t), compare_length);
+
+    for(i = 0; i < num_rows; i += lanes){
+        for(lane = 0; lane < lanes; lane++)
+            L[lane] = i + lane < num_rows ? digitize(msa_sequence(msa, order[i + lane].row), msa->N, dsq + lane * stride) : 0;
+        kernel->batch(profile, dsq, stride, L, dp, score);
+        for(lane = 0; lane < lanes && i + lane < num_rows; lane++)
+            chunk->scores[order[i + lane].row] = bit_score(score[lane], L[lane]);
+    }
+
+    free(order);
+    return 0;
+}
+
+/* Score the rows of one block along their alignment, a row without a match state gets its full Viterbi score
+ * Input:   the block
+ * Output:  0 on success, ERROR otherwise
+ * Effect:  calls malloc, set the scores of the rows of the block
+ */
+int score_rows_aligned(score_chunk_t * chunk){
+    profile_t * profile = chunk->profile;
+    msa_t * msa = chunk->msa;
+    float * dp;             // match, insert and delete rows of the DP matrix
+    char * dsq;             // residue codes of the sequence without its gaps
+    int * node;             // node each residue is aligned to
+    trace_t trace;          // path of the sequence
+    float score;
+    int i, L;
+
+    node = malloc((msa->N + 1) * sizeof(int));
+    trace.state     = malloc((msa->N + 1) * sizeof(char));
+    trace.node      = malloc((msa->N + 1) * sizeof(int));
+    trace.residue   = malloc((msa->N + 1) * sizeof(int));
+    if(!node || !trace.state || !trace.node || !trace.residue
+    || get_scratch(3 * (size_t) profile->Q * VITERBI_LANES * sizeof(float), msa->N + 1, &dp, &dsq) != SUCCESS){
+        free(node); free(trace.state); free(trace.node); free(trace.residue);
+        PRINT_AND_RETURN("malloc failed in score_rows_aligned",     MALLOC_ERROR);
+    }
+
+    for(i = chunk->first; i < chunk->last; i++){
+        L = path_nodes(msa_sequence(msa, i), msa->N, chunk->column_node, dsq, node);
+        if(L == 0){
+            chunk->scores[i] = 0;
+            continue;
+        }
+        if(chunk->band > 0)
+            score = viterbi_banded(profile, dsq, L, node, chunk->band, dp);
+        else {
+            trace_sequence(msa_sequence(msa, i), msa->N, profile->M, chunk->column_node, &trace);
+            doctor_trace(&trace);
+            score = path_score(profile, &trace, L);
+        }
+        if(score == -INFINITY)
+            score = viterbi_single(chunk->kernel, profile, dsq, L, dp);
+        chunk->scores[i] = bit_score(score, L);
+    }
+
+    free(node); free(trace.state); free(trace.node); free(trace.residue);
+    return 0;
+}
+
+/* Residue codes of an aligned sequence without its gaps and the node each residue is aligned to: the node of its match
+ * column, or the node of the last match column before it for an insert column (node 1 before the first match column)
+ * Input:   the aligned sequence, its length, the node of each column, room for N codes and N nodes
+ * Output:  the number of residues
+ * Effect:  set dsq and node
+ */
+int path_nodes(char * sequence, int N, int * column_node, char * dsq, int * node){
+    int c, L, k, code;
+
+    k = 1;
+    for(L = 0, c = 0; c < N && sequence[c]; c++){
+        if(column_node[c]) k = column_node[c];
+        if((code = residue_code(sequence[c]))){
+            dsq[L] = code;
+            node[L++] = k;
+        }
+    }
+    return L;
+}
+
+/* Score in nats of a doctored trace in the local multihit model: the begin state enters at the first match state,
+ * the end state is reached from the last one and the L - n other residues, n being the residues of the states in between,
+ * are emitted by the N and C states
+ * Input:   the profile, the trace and the length of the sequence
+ * Output:  the score of the path, -infinity if the trace has no match state
+ * Effect:  none
+ */
+float path_score(profile_t * profile, trace_t * trace, int L){
+    // Transition from the state in the row to the state in the column, the first three go into the node of the column
+    static const int transition[3][3] = {
+        { PROFILE_TMM, PROFILE_TMI, PROFILE_TMD },
+        { PROFILE_TIM, PROFILE_TII, -1          },
+        { PROFILE_TDM, -1,          PROFILE_TDD }
+    };
+    float loop, move, score;
+    int first, last, z, s, n;
+
+    for(first = 0; first < trace->length && trace->state[first] != STATE_M; first++);
+    if(first == trace->length) return -INFINITY;
+    for(last = trace->length - 1; trace->state[last] != STATE_M; last--);
+
+    loop = logf((float) L / (L + 3));
+    move = logf(3.0f / (L + 3));
+    score = move + profile_node_tsc(profile, trace->node[first])[PROFILE_TBM];
+    for(n = 0, z = first; z <= last; z++){
+        if(z > first){
+            s = transition[(int) trace->state[z - 1]][(int) trace->state[z]];
+            if(s < 0) return -INFINITY;
+            score += profile_node_tsc(profile, s <= PROFILE_TDM ? trace->node[z] : trace->node[z - 1])[s];
+        }
+        if(trace->state[z] == STATE_M)  score += profile_node_msc(profile, trace->node[z])[trace->residue[z]];
+        if(trace->state[z] != STATE_D)  n++;
+    }
+    return score + (L - n) * loop + (float) -M_LN2 + move;
+}
+
+/* Viterbi score of a sequence in nats over the nodes near its alignment: residue i is only matched or inserted at nodes
+ * within band of node[i] and of node[i + 1], the nodes in between staying reachable through delete states
+ * Cells outside the band of a row are kept at -infinity, so a row only reads the cells the previous row computed
+ * Input:   the profile, the residue codes of the sequence, its length, the node of each residue, the band
+ *          and room for 3 x Q x VITERBI_LANES floats
+ * Output:  the score of the best path in the band
+ * Effect:  overwrite dp
+ */
+float viterbi_banded(profile_t * profile, char * dsq, int L, int * node, int band, float * dp){
+    float * mmx = dp - 1, * imx = mmx + profile->Q * VITERBI_LANES, * dmx = imx + profile->Q * VITERBI_LANES;    // indexed by node
+    float loop, move, xN, xB, xE, xJ, xC;
+    float sv, mpv, ipv, dpv, dcv;
+    float * t;
+    int i, k, lo, hi, last_lo, last_hi;
+
+    for(k = 1; k <= profile->M; k++) mmx[k] = imx[k] = dmx[k] = -INFINITY;
+
+    loop = logf((float) L / (L + 3));
+    move = logf(3.0f / (L + 3));
+    xN = 0;
+    xB = move;
+    xJ = xC = -INFINITY;
+
+    last_lo = 1;
+    last_hi = 0;
+    for(i = 0; i < L; i++){
+        lo = node[i] - band;
+        hi = (i + 1 < L && node[i + 1] > node[i] ? node[i + 1] : node[i]) + band;
+        if(lo < 1)              lo = 1;
+        if(hi > profile->M)     hi = profile->M;
+
+        mpv = ipv = dpv = dcv = xE = -INFINITY;
+        if(lo > 1){
+            mpv = mmx[lo - 1];
+            ipv = imx[lo - 1];
+            dpv = dmx[lo - 1];
+        }
+        for(k = lo; k <= hi; k++){
+            t = profile_node_tsc(profile, k);
+
+            sv = xB + t[PROFILE_TBM];
+            sv = fmaxf(sv, mpv + t[PROFILE_TMM]);
+            sv = fmaxf(sv, ipv + t[PROFILE_TIM]);
+            sv = fmaxf(sv, dpv + t[PROFILE_TDM]);
+            sv += profile_node_msc(profile, k)[(int) dsq[i]];
+
+            mpv = mmx[k];
+            ipv = imx[k];
+            dpv = dmx[k];
+            mmx[k] = sv;
+            imx[k] = fmaxf(mpv + t[PROFILE_TMI], ipv + t[PROFILE_TII]);
+            dmx[k] = dcv;
+            dcv = fmaxf(sv + t[PROFILE_TMD], dmx[k] + t[PROFILE_TDD]);
+            xE = fmaxf(xE, fmaxf(sv, dmx[k]));
+        }
+
+        // Cells of the previous band this row left behind
+        for(k = last_lo; k <= last_hi; k++)
+            if(k < lo || k > hi) mmx[k] = imx[k] = dmx[k] = -INFINITY;
+        last_lo = lo;
+        last_hi = hi;
+
+        xN = xN + loop;
+        xC = fmaxf(xC + loop, xE + (float) -M_LN2);
+        xJ = fmaxf(xJ + loop, xE + (float) -M_LN2);
+        xB = fmaxf(xN + move, xJ + move);
+    }
+    return xC + move;
+}
+
+void * score_chunk(void * chunk){
+    score_chunk_t * c = chunk;
+    c->status = score_rows(c);
+    return NULL;
+}
+
+/* DP rows and residue codes of the calling thread, grown to at least the sizes asked. They stay valid until the next
+ * call on the thread
+ * Input:   the bytes of DP rows and of residue codes needed, where to put them
+ * Output:  0 on success, ERROR otherwise
+ * Effect:  calls malloc the first time and when the sizes grow, set dp and dsq
+ */
+int get_scratch(size_t dp_size, size_t dsq_size, float ** dp, char ** dsq){
+    scratch_t * scratch;
+    float * new_dp;
+    char * new_dsq;
+
+    pthread_once(&scratch_once, make_scratch_key);
+    scratch = pthread_getspecific(scratch_key);
+    if(!scratch){
+        scratch = calloc(1, sizeof(scratch_t));
+        if(!scratch)                                PRINT_AND_RETURN("malloc failed in get_scratch",     MALLOC_ERROR);
+        if(pthread_setspecific(scratch_key, scratch) != 0){
+            free(scratch);
+            PRINT_AND_RETURN("cannot keep scratch in get_scratch",                                  GENERAL_ERROR);
+        }
+    }
+    if(scratch->dp_size < dp_size){
+        if(posix_memalign((void **) &new_dp, MSA_ALIGNMENT, dp_size) != 0)
+                                                    PRINT_AND_RETURN("malloc failed in get_scratch",     MALLOC_ERROR);
+        free(scratch->dp);
+        scratch->dp = new_dp;
+        scratch->dp_size = dp_size;
+    }
+    if(scratch->dsq_size < dsq_size){
+        new_dsq = malloc(dsq_size);
+        if(!new_dsq)                                PRINT_AND_RETURN("malloc failed in get_scratch",     MALLOC_ERROR);
+        free(scratch->dsq);
+        scratch->dsq = new_dsq;
+        scratch->dsq_size = dsq_size;
+    }
+    *dp = scratch->dp;
+    *dsq = scratch->dsq;
+    return 0;
+}
+
+void make_scratch_key(void){
+    pthread_key_create(&scratch_key, free_scratch);
+}
+
+void free_scratch(void * scratch){
+    scratch_t * s = scratch;
+    free(s->dp);
+    free(s->dsq);
+    free(s);
+}
+
+/* Viterbi score of a sequence in nats, one node at a time. This is the reference the striped version must agree with
+ * Row i of the DP matrix is computed in place over row i - 1: the value of node k of the previous row is read before it is overwritten
+ * Input:   the profile, the residue codes of the sequence, its length and room for 3 x Q x VITERBI_LANES floats
+ * Output:  the score of the best path
+ * Effect:  overwrite dp
+ */
+float viterbi_scalar(profile_t * profile, char * dsq, int L, float * dp){
+    float * mmx = dp - 1, * imx = mmx + profile->Q * VITERBI_LANES, * dmx = imx + profile->Q * VITERBI_LANES;    // indexed by node
+    float loop, move, xN, xB, xE, xJ, xC;
+    float sv, mpv, ipv, dpv, dcv;
+    int i, k, q, z;
+
+#define SCALAR_TSC(s)   profile_tsc(profile, s, q)[z]
+    for(k = 1; k <= profile->M; k++) mmx[k] = imx[k] = dmx[k] = -INFINITY;
+
+    // Special states for a sequence of length L, multihit
+    loop = logf((float) L / (L + 3));
+    move = logf(3.0f / (L + 3));
+    xN = 0;
+    xB = move;
+    xJ = xC = -INFINITY;
+
+    for(i = 0; i < L; i++){
+        mpv = ipv = dpv = dcv = xE = -INFINITY;
+        for(k = 1; k <= profile->M; k++){
+            q = (k - 1) % profile->Q;
+            z = (k - 1) / profile->Q;
+
+            sv = xB + SCALAR_TSC(PROFILE_TBM);
+            sv = fmaxf(sv, mpv + SCALAR_TSC(PROFILE_TMM));
+            sv = fmaxf(sv, ipv + SCALAR_TSC(PROFILE_TIM));
+            sv = fmaxf(sv, dpv + SCALAR_TSC(PROFILE_TDM));
+            sv += profile_msc(profile, dsq[i], q)[z];
+
+            mpv = mmx[k];
+            ipv = imx[k];
+            dpv = dmx[k];
+            mmx[k] = sv;
+            imx[k] = fmaxf(mpv + SCALAR_TSC(PROFILE_TMI), ipv + SCALAR_TSC(PROFILE_TII));
+            dmx[k] = dcv;
+            dcv = fmaxf(sv + SCALAR_TSC(PROFILE_TMD), dmx[k] + SCALAR_TSC(PROFILE_TDD));
+            xE = fmaxf(xE, fmaxf(sv, dmx[k]));
+        }
+
+        xN = xN + loop;
+        xC = fmaxf(xC + loop, xE + (float) -M_LN2);
+        xJ = fmaxf(xJ + loop, xE + (float) -M_LN2);
+        xB = fmaxf(xN + move, xJ + move);
+    }
+#undef SCALAR_TSC
+    return xC + move;
+}
+
+#ifdef __SSE2__
+// Shift the lanes of a vector up by one, lane 0 gets -infinity: node k of a stripe becomes node k + 1 of the next stripe
+#define SHIFT_LANES(v)  _mm_move_ss(_mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 1, 0, 3)), neginf)
+
+/* Viterbi score of a sequence in nats, VITERBI_LANES nodes at a time on the striped profile (Farrar)
+ * Paths through delete states are first computed from the match states of the same row only,
+ * then the delete to delete transitions are propagated across the stripes, which takes at most one pass per lane
+ * Input:   the profile, the residue codes of the sequence, its length and room for 3 x Q x VITERBI_LANES floats aligned to 16 bytes
+ * Output:  the score of the best path
+ * Effect:  overwrite dp
+ */
+float viterbi_striped(profile_t * profile, char * dsq, int L, float * dp){
+    int Q = profile->Q;
+    __m128 * mmx = (__m128 *) dp, * imx = mmx + Q, * dmx = imx + Q;
+    __m128 * rsc, * tsc;
+    __m128 neginf, sv, mpv, ipv, dpv, dcv, xEv, xBv;
+    float loop, move, xN, xB, xE, xJ, xC;
+    float lanes[VITERBI_LANES];
+    int i, q, j;
+
+    neginf = _mm_set1_ps(-INFINITY);
+    for(q = 0; q < 3 * Q; q++) mmx[q] = neginf;
+
+    loop = logf((float) L / (L + 3));
+    move = logf(3.0f / (L + 3));
+    xN = 0;
+    xB = move;
+    xJ = xC = -INFINITY;
+
+    for(i = 0; i < L; i++){
+        rsc = (__m128 *) profile_msc(profile, dsq[i], 0);
+        tsc = (__m128 *) profile->tsc;
+        xEv = neginf;
+        dcv = neginf;
+        xBv = _mm_set1_ps(xB);
+        mpv = SHIFT_LANES(mmx[Q - 1]);
+        ipv = SHIFT_LANES(imx[Q - 1]);
+        dpv = SHIFT_LANES(dmx[Q - 1]);
+
+        for(q = 0; q < Q; q++){
+            sv = _mm_add_ps(xBv, tsc[PROFILE_TBM * Q + q]);
+            sv = _mm_max_ps(sv, _mm_add_ps(mpv, tsc[PROFILE_TMM * Q + q]));
+            sv = _mm_max_ps(sv, _mm_add_ps(ipv, tsc[PROFILE_TIM * Q + q]));
+            sv = _mm_max_ps(sv, _mm_add_ps(dpv, tsc[PROFILE_TDM * Q + q]));
+            sv = _mm_add_ps(sv, rsc[q]);
+            xEv = _mm_max_ps(xEv, sv);
+
+            mpv = mmx[q];
+            ipv = imx[q];
+            dpv = dmx[q];
+            mmx[q] = sv;
+            imx[q] = _mm_max_ps(_mm_add_ps(mpv, tsc[PROFILE_TMI * Q + q]), _mm_add_ps(ipv, tsc[PROFILE_TII * Q + q]));
+            dmx[q] = dcv;
+            dcv = _mm_add_ps(sv, tsc[PROFILE_TMD * Q + q]);
+        }
+
+        // Delete to delete paths
+        for(j = 0; j < VITERBI_LANES; j++){
+            dcv = SHIFT_LANES(dcv);
+            for(q = 0; q < Q; q++){
+                dmx[q] = _mm_max_ps(dcv, dmx[q]);
+                dcv = _mm_add_ps(dmx[q], tsc[PROFILE_TDD * Q + q]);
+            }
+        }
+        for(q = 0; q < Q; q++) xEv = _mm_max_ps(xEv, dmx[q]);
+
+        _mm_storeu_ps(lanes, xEv);
+        xE = fmaxf(fmaxf(lanes[0], lanes[1]), fmaxf(lanes[2], lanes[3]));
+        xN = xN + loop;
+        xC = fmaxf(xC + loop, xE + (float) -M_LN2);
+        xJ = fmaxf(xJ + loop, xE + (float) -M_LN2);
+        xB = fmaxf(xN + move, xJ + move);
+    }
+    return xC + move;
+}
+#undef SHIFT_LANES
+#endif
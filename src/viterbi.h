@@ -0,0 +1,69 @@
+// File in HMMDecompositionDecision, created by Thien Le in July 2018
+
+#ifndef VITERBI_H
+#define VITERBI_H
+
+#include "msa.h"
+#include "hmm.h"
+
+// Number of float lanes in one vector of the striped layout (SSE)
+#define VITERBI_LANES           4
+
+// Largest DP row, in nodes times lanes, of the inter-sequence kernels. It takes 12 bytes per cell, past this size
+// it falls out of the cache and the striped kernel, with the memory of a single sequence, is left
+#define VITERBI_BATCH_MAX_CELLS 262144
+
+// Number of residue codes (sets of nucleotides, see residue_code)
+#define NUM_RESIDUE_CODES       16
+
+// Transition scores of the striped profile. The first four go into node k from node k - 1 (or from the begin state),
+// the others leave node k
+enum profile_transition {
+    PROFILE_TBM, PROFILE_TMM, PROFILE_TIM, PROFILE_TDM,
+    PROFILE_TMD, PROFILE_TMI, PROFILE_TII, PROFILE_TDD,
+    PROFILE_NUM_TRANSITIONS
+};
+
+// Profile of an hmm configured for local multihit alignment the way hmmsearch does, in log space (nats)
+// The striped copy serves the kernel running one sequence over the lanes: node k is stored in vector (k - 1) % Q
+// at lane (k - 1) / Q (Farrar striping), lanes past M hold -infinity
+// The node-major copy serves the kernel running one sequence per lane, which reads the scores of one node at a time
+typedef struct profile {
+    int     M;          // number of match states
+    int     Q;          // number of vectors holding one row of the model
+    float*  msc;        // NUM_RESIDUE_CODES x Q striped match emission scores
+    float*  tsc;        // PROFILE_NUM_TRANSITIONS x Q striped transition scores
+    float*  node_msc;   // (M + 1) x NUM_RESIDUE_CODES match emission scores, row 0 unused
+    float*  node_tsc;   // (M + 1) x PROFILE_NUM_TRANSITIONS transition scores, row 0 unused
+} profile_t;
+
+// Accessors to the first float of a striped vector
+#define profile_msc(p, x, q)    ((p)->msc + ((size_t) (x) * (p)->Q + (q)) * VITERBI_LANES)
+#define profile_tsc(p, s, q)    ((p)->tsc + ((size_t) (s) * (p)->Q + (q)) * VITERBI_LANES)
+
+// Accessors to the scores of node k
+#define profile_node_msc(p, k)  ((p)->node_msc + (size_t) (k) * NUM_RESIDUE_CODES)
+#define profile_node_tsc(p, k)  ((p)->node_tsc + (size_t) (k) * PROFILE_NUM_TRANSITIONS)
+
+// Constructor & destructor
+extern int init_profile(profile_t * profile);
+extern void destroy_profile(profile_t * profile);
+
+extern int build_profile(profile_t * profile, hmm_t * hmm);
+
+// Viterbi bit score of every sequence of an msa (gaps removed) against the profile, scores holds num_seq floats
+// Many sequences on a short model are scored several at a time across the lanes, otherwise one at a time over striped lanes
+extern int score_msa(profile_t * profile, msa_t * msa, int num_threads, float * scores);
+
+// Same scores restricted to the path each row takes through hmm in the alignment it was built from (the columns of msa):
+// band 0 scores that path alone in O(N) per row, a positive band runs Viterbi over the nodes within band of the path
+extern int score_msa_aligned(profile_t * profile, hmm_t * hmm, msa_t * msa, int band, int num_threads, float * scores);
+
+// The Viterbi kernels are compiled for several instruction sets and the fastest the cpu supports is used, unless set_kernel
+// names one (scalar, sse2, sse4.1, avx2 or avx512, NULL to go back to the fastest). check_kernels scores an msa with every
+// supported kernel and fails unless all the scores are identical
+extern int set_kernel(char * name);
+extern char * kernel_name(void);
+extern int check_kernels(profile_t * profile, msa_t * msa);
+
+#endif
@@ -0,0 +1,88 @@
+// File in HMMDecompositionDecision, created by Thien Le in July 2018
+
+/* Body of the inter-sequence Viterbi kernel, included once per instruction set by kernel.c with these macros set:
+ *   BATCH_NAME             name of the function
+ *   LANES                  number of floats in a vector
+ *   VEC, MASK, RESIDUES    vector of floats, comparison mask and the residue codes of the lanes as taken by EMISSIONS
+ *   VSET1, VZERO, VLOADU, VSTOREU, VADD, VMAX
+ *   VNEGATIVE(v)           mask of the lanes of v below 0
+ *   VSELECT(m, a, b)       lanes of a where m is set and lanes of b elsewhere
+ *   LOAD_RESIDUES(x)       RESIDUES from an array of LANES ints
+ *   EMISSIONS(e, r)        vector of e[r[lane]]
+ * Every variant performs the same additions and maxima in the same order as viterbi_scalar, so the scores are identical
+ *
+ * Viterbi scores of LANES sequences at once, one per lane, computing the nodes one at a time as viterbi_scalar does
+ * All lanes share the transition scores of a node and gather their emission score from the residue of their own sequence
+ * A lane whose sequence has ended sees residue code 0 (score -infinity) and its score is the one taken after its last residue
+ * Input:   the profile, the residue codes of each lane at dsq + lane * stride, the length of each lane,
+ *          room for 3 x (M + 1) x LANES floats aligned to MSA_ALIGNMENT and LANES floats receiving the scores in nats
+ * Output:  nothing
+ * Effect:  overwrite dp, set score
+ */
+void BATCH_NAME(profile_t * profile, char * dsq, int stride, int * L, float * dp, float * score){
+    int M = profile->M;
+    VEC * mmx = (VEC *) dp, * imx = mmx + M + 1, * dmx = imx + M + 1;
+    VEC neginf, sv, mpv, ipv, dpv, dcv, xE, xN, xB, xJ, xC, loop, move, esc, result;
+    MASK done;
+    RESIDUES r;
+    float lane_loop[LANES], lane_move[LANES], lane_done[LANES];
+    float * t, * e;
+    int x[LANES];
+    int i, k, lane, max_L;
+
+    neginf = VSET1(-INFINITY);
+    for(k = 0; k < 3 * (M + 1); k++) mmx[k] = neginf;
+
+    // Special states for the length of each lane
+    max_L = 0;
+    for(lane = 0; lane < LANES; lane++){
+        lane_loop[lane] = logf((float) L[lane] / (L[lane] + 3));
+        lane_move[lane] = logf(3.0f / (L[lane] + 3));
+        if(L[lane] > max_L) max_L = L[lane];
+    }
+    loop = VLOADU(lane_loop);
+    move = VLOADU(lane_move);
+    esc = VSET1((float) -M_LN2);     // E to C or J
+    xN = VZERO();
+    xB = move;
+    xJ = xC = result = neginf;
+
+    for(i = 0; i < max_L; i++){
+        for(lane = 0; lane < LANES; lane++){
+            x[lane] = i < L[lane] ? dsq[lane * stride + i] : 0;
+            lane_done[lane] = i == L[lane] - 1 ? -1.0f : 0.0f;
+        }
+        r = LOAD_RESIDUES(x);
+
+        mpv = ipv = dpv = dcv = xE = neginf;
+        for(k = 1; k <= M; k++){
+            t = profile_node_tsc(profile, k);
+            e = profile_node_msc(profile, k);
+
+            sv = VADD(xB, VSET1(t[PROFILE_TBM]));
+            sv = VMAX(sv, VADD(mpv, VSET1(t[PROFILE_TMM])));
+            sv = VMAX(sv, VADD(ipv, VSET1(t[PROFILE_TIM])));
+            sv = VMAX(sv, VADD(dpv, VSET1(t[PROFILE_TDM])));
+            sv = VADD(sv, EMISSIONS(e, r));
+
+            mpv = mmx[k];
+            ipv = imx[k];
+            dpv = dmx[k];
+            mmx[k] = sv;
+            imx[k] = VMAX(VADD(mpv, VSET1(t[PROFILE_TMI])), VADD(ipv, VSET1(t[PROFILE_TII])));
+            dmx[k] = dcv;
+            dcv = VMAX(VADD(sv, VSET1(t[PROFILE_TMD])), VADD(dmx[k], VSET1(t[PROFILE_TDD])));
+            xE = VMAX(xE, VMAX(sv, dmx[k]));
+        }
+
+        xN = VADD(xN, loop);
+        xC = VMAX(VADD(xC, loop), VADD(xE, esc));
+        xJ = VMAX(VADD(xJ, loop), VADD(xE, esc));
+        xB = VMAX(VADD(xN, move), VADD(xJ, move));
+
+        // Keep the score of the lanes whose sequence ends with this residue
+        done = VNEGATIVE(VLOADU(lane_done));
+        result = VSELECT(done, VADD(xC, move), result);
+    }
+    VSTOREU(score, result);
+}
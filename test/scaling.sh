@@ -0,0 +1,68 @@
+#!/bin/sh
+# File in HMMDecompositionDecision, created by Thien Le in July 2018
+#
+# Memory scaling of the pipeline with the number of sequences: generates alignments of 2 clusters with 1k to 500k rows,
+# runs decide on each with --profile and prints the peak resident set after parsing and over the whole run. Memory is
+# linear in the input when the kB each row adds over the previous size (the last column) stay flat as the rows grow.
+# FastTree is replaced by a stub writing a balanced tree of the input names, so the tree, the decomposition, the hmms
+# and the scores are all sized by the input without the hours FastTree takes on 500k sequences.
+#
+# Usage: test/scaling.sh [path to decide] [rows...]     (from the root of the repository)
+
+DECIDE=${1:-src/decide}
+[ $# -gt 0 ] && shift
+SIZES=${*:-1000 10000 100000 500000}
+LENGTH=100
+
+WORK=$(mktemp -d "${TMPDIR:-/tmp}/scaling.XXXXXX") || exit 1
+trap 'rm -rf "$WORK"' EXIT
+
+# Stub of FastTree: the last argument is the alignment, the tree goes to stdout
+cat > "$WORK/FastTree" <<'EOF'
+#!/bin/sh
+for last; do :; done
+awk '/^>/ { n++; split(substr($0, 2), word, /[ \t]/); node[n] = word[1] }
+     END {
+         while(n > 1){
+             m = 0
+             for(i = 1; i + 1 <= n; i += 2) node[++m] = "(" node[i] ":0.1," node[i + 1] ":0.1)"
+             if(i == n) node[++m] = node[n]
+             n = m
+         }
+         print node[1] ";"
+     }' "$last"
+EOF
+chmod +x "$WORK/FastTree"
+
+printf "%8s %10s %12s %12s %12s\n" rows input_MB parse_RSS_MB peak_RSS_MB added_kB/row
+PREV_ROWS=0
+PREV_PEAK=0
+for ROWS in $SIZES; do
+    # Each half mutates 10% of the columns of its own template
+    awk -v rows="$ROWS" -v len="$LENGTH" 'BEGIN {
+        srand(1)
+        split("A C G T", base, " ")
+        for(c = 1; c <= 2; c++) for(j = 1; j <= len; j++) template[c, j] = base[int(4 * rand()) + 1]
+        for(r = 1; r <= rows; r++){
+            c = r <= rows / 2 ? 1 : 2
+            s = ""
+            for(j = 1; j <= len; j++) s = s (rand() < 0.9 ? template[c, j] : base[int(4 * rand()) + 1])
+            print ">s" r
+            print s
+        }
+    }' > "$WORK/input.fa"
+
+    if ! PATH="$WORK:$PATH" "$DECIDE" -i "$WORK/input.fa" --score path --profile "$WORK/report.json" > "$WORK/output.txt" 2>&1; then
+        echo "decide failed on $ROWS rows:"
+        cat "$WORK/output.txt"
+        exit 1
+    fi
+
+    INPUT=$(wc -c < "$WORK/input.fa")
+    PEAK=$(sed -n 's/.*"user": [0-9.]*, "sys": [0-9.]*, "max_rss_kb": \([0-9]*\),$/\1/p' "$WORK/report.json")
+    PARSE=$(sed -n 's/.*"stage": "parse input".*"max_rss_kb": \([0-9]*\).*/\1/p' "$WORK/report.json")
+    awk -v rows="$ROWS" -v input="$INPUT" -v parse="$PARSE" -v peak="$PEAK" -v prev_rows="$PREV_ROWS" -v prev_peak="$PREV_PEAK" \
+        'BEGIN { printf "%8d %10.1f %12.1f %12.1f %12.3f\n", rows, input / 1048576, parse / 1024, peak / 1024, (peak - prev_peak) / (rows - prev_rows) }'
+    PREV_ROWS=$ROWS
+    PREV_PEAK=$PEAK
+done